@@ -19,29 +19,11 @@ if(REDUCT_CPP_USE_FETCHCONTENT)
         URL_HASH MD5=af82eb38506ca531b6d1d53524ff7912
     )
 
-    FetchContent_Declare(
-        concurrentqueue
-        URL
-            https://github.com/cameron314/concurrentqueue/archive/refs/tags/v1.0.4.zip
-        URL_HASH MD5=814c5e121b29e37ee836312f0eb0328f
-    )
-
-    #    FetchContent_Declare(
-    #        zlib
-    #        URL https://github.com/madler/zlib/releases/download/v1.3.1/zlib131.zip
-    #        URL_HASH MD5=ef76f7ebfd97778a6653b1d8413541c0
-    #    )
-
     FetchContent_MakeAvailable(
         fmt
         nlohmann_json
         httplib
-        concurrentqueue
-        #        zlib
     )
-
-    # Add aliases
-    add_library(concurrentqueue::concurrentqueue ALIAS concurrentqueue)
 else()
     find_package(fmt 9.1.0 REQUIRED)
     find_package(nlohmann_json 3.11.3 REQUIRED)
@@ -57,26 +39,23 @@ else()
         pkg_check_modules(httplib REQUIRED IMPORTED_TARGET cpp-httplib>=0.14.3)
         add_library(httplib::httplib ALIAS PkgConfig::httplib)
     endif()
-
-    if(NOT VCPKG_ENABLED)
-        find_package(concurrentqueue 1.0 REQUIRED)
-    else()
-        find_package(unofficial-concurrentqueue REQUIRED)
-        add_library(
-            concurrentqueue::concurrentqueue
-            ALIAS unofficial::concurrentqueue::concurrentqueue
-        )
-    endif()
 endif()
 
 find_package(OpenSSL 3.0.13 REQUIRED)
 
+if(REDUCT_CPP_ENABLE_COMPRESSION)
+    find_package(ZLIB REQUIRED)
+endif()
+
 # Set dependencies list
 set(RCPP_DEPENDENCIES
     fmt::fmt
     nlohmann_json::nlohmann_json
     httplib::httplib
-    concurrentqueue::concurrentqueue
     OpenSSL::SSL
     OpenSSL::Crypto
 )
+
+if(REDUCT_CPP_ENABLE_COMPRESSION)
+    list(APPEND RCPP_DEPENDENCIES ZLIB::ZLIB)
+endif()
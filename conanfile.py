@@ -30,7 +30,6 @@ class DriftFrameworkConan(ConanFile):
         "cpp-httplib/0.14.3",
         "nlohmann_json/3.11.3",
         "openssl/3.0.13",
-        "concurrentqueue/1.0.4",
     )
 
     def set_version(self):
@@ -0,0 +1,226 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/batch_writer.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "reduct/internal/codec.h"
+
+namespace reduct {
+
+class BatchWriter : public IBatchWriter {
+ public:
+  BatchWriter(const IBucket& bucket, Options options) : bucket_(bucket), options_(options) {
+    const auto sender_count = std::max<size_t>(options_.max_in_flight, 1);
+    for (size_t i = 0; i < sender_count; ++i) {
+      senders_.emplace_back([this] { Run(); });
+    }
+  }
+
+  ~BatchWriter() override {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& sender : senders_) {
+      sender.join();
+    }
+  }
+
+  void Write(std::string_view entry_name, const IBucket::WriteOptions& options, std::string data,
+             CompletionCallback on_complete) noexcept override {
+    auto labels = options.labels;
+    // compress before taking the lock, so the producers compress in parallel
+    if (auto compressed = internal::CompressRecord(data, options.compression)) {
+      data = std::move(*compressed);
+      labels[std::string(internal::kEncodingLabel)] = internal::kGzipEncoding;
+    }
+
+    const auto size = data.size();
+
+    std::unique_lock lock(mutex_);
+    // backpressure: a producer faster than the server waits for the sent batches
+    cv_.wait(lock, [this, size] { return buffered_size_ == 0 || buffered_size_ + size <= options_.max_buffer_size; });
+
+    const auto timestamp = options.timestamp ? *options.timestamp : NextTimestamp(entry_name);
+    if (!current_) {
+      current_.emplace();
+      current_->deadline = std::chrono::steady_clock::now() + options_.linger;
+    }
+
+    current_->batch.AddRecord(std::string(entry_name), timestamp, data, options.content_type, std::move(labels));
+    current_->entries.emplace(entry_name);
+    current_->callbacks.push_back(std::move(on_complete));
+    buffered_size_ += size;
+
+    if (current_->batch.size() >= options_.max_batch_size ||
+        current_->batch.records().size() >= options_.max_batch_records) {
+      ready_.push_back(std::move(*current_));
+      current_.reset();
+      cv_.notify_all();
+    } else if (current_->callbacks.size() == 1) {
+      // the sender must wake up at the deadline of the new batch
+      cv_.notify_all();
+    }
+  }
+
+  void Flush() noexcept override {
+    std::unique_lock lock(mutex_);
+    if (current_) {
+      ready_.push_back(std::move(*current_));
+      current_.reset();
+      cv_.notify_all();
+    }
+
+    cv_.wait(lock, [this] { return ready_.empty() && in_flight_ == 0; });
+  }
+
+ private:
+  struct PendingBatch {
+    IBucket::Batch batch;
+    std::vector<CompletionCallback> callbacks;  // in the order of batch.records()
+    std::set<std::string, std::less<>> entries;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  void Run() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+      if (current_ && (stop_ || std::chrono::steady_clock::now() >= current_->deadline)) {
+        ready_.push_back(std::move(*current_));
+        current_.reset();
+      }
+
+      auto next = NextReady();
+      if (next == ready_.end()) {
+        if (stop_ && ready_.empty()) {
+          return;
+        }
+
+        if (current_) {
+          cv_.wait_until(lock, current_->deadline);
+        } else {
+          cv_.wait(lock);
+        }
+        continue;
+      }
+
+      auto pending = std::move(*next);
+      ready_.erase(next);
+      in_flight_entries_.insert(pending.entries.begin(), pending.entries.end());
+      ++in_flight_;
+      auto entries = pending.entries;
+      lock.unlock();
+
+      const auto size = pending.batch.size();
+      Send(std::move(pending));
+
+      lock.lock();
+      for (const auto& entry : entries) {
+        in_flight_entries_.erase(in_flight_entries_.find(entry));
+      }
+      --in_flight_;
+      buffered_size_ -= size;
+      cv_.notify_all();
+    }
+  }
+
+  /**
+   * The current time for a record without a timestamp. The server keeps one record per microsecond of an entry,
+   * so the time is moved forward if it isn't later than the previous one of the entry. Call under the lock.
+   */
+  IBucket::Time NextTimestamp(std::string_view entry_name) {
+    const IBucket::Time now = std::chrono::time_point_cast<std::chrono::microseconds>(IBucket::Time::clock::now());
+    auto last = last_timestamps_.find(entry_name);
+    if (last == last_timestamps_.end()) {
+      last_timestamps_.emplace(entry_name, now);
+      return now;
+    }
+
+    last->second = std::max(now, last->second + std::chrono::microseconds(1));
+    return last->second;
+  }
+
+  /**
+   * The first ready batch which may be sent now
+   */
+  std::deque<PendingBatch>::iterator NextReady() {
+    if (!options_.keep_order) {
+      return ready_.begin();
+    }
+
+    // a batch waits for the batches with the same entries which are in flight or wait before it
+    auto blocked = in_flight_entries_;
+    for (auto it = ready_.begin(); it != ready_.end(); ++it) {
+      if (std::none_of(it->entries.begin(), it->entries.end(),
+                       [&blocked](const auto& entry) { return blocked.contains(entry); })) {
+        return it;
+      }
+      blocked.insert(it->entries.begin(), it->entries.end());
+    }
+
+    return ready_.end();
+  }
+
+  void Send(PendingBatch pending) const {
+    const auto& records = pending.batch.records();
+    std::vector<std::pair<std::string, IBucket::Time>> keys;
+    keys.reserve(records.size());
+    for (const auto& record : records) {
+      keys.emplace_back(record.entry, record.timestamp);
+    }
+
+    auto [errors, err] = bucket_.WriteBatch([&pending](IBucket::Batch* batch) { *batch = std::move(pending.batch); });
+
+    // a failed request of a split batch reports all the records it didn't write, the records without an error
+    // are written. Only a batch which failed before its requests were sent has no errors of records
+    const bool records_reported =
+        std::any_of(errors.begin(), errors.end(), [](const auto& entry) { return !entry.second.empty(); });
+    for (size_t i = 0; i < keys.size(); ++i) {
+      auto record_err = records_reported ? Error::kOk : err;
+      if (auto entry = errors.find(keys[i].first); entry != errors.end()) {
+        if (auto error = entry->second.find(keys[i].second); error != entry->second.end()) {
+          record_err = error->second;
+        }
+      }
+
+      if (pending.callbacks[i]) {
+        pending.callbacks[i](std::move(record_err));
+      }
+    }
+  }
+
+  const IBucket& bucket_;
+  Options options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::optional<PendingBatch> current_;  // batch which receives new records
+  std::deque<PendingBatch> ready_;       // batches waiting for a sender
+  std::multiset<std::string, std::less<>> in_flight_entries_;  // entries of the batches being sent
+  size_t in_flight_ = 0;      // number of the batches being sent
+  size_t buffered_size_ = 0;  // bytes of data in current_, ready_ and the batches being sent
+  bool stop_ = false;
+  std::map<std::string, IBucket::Time, std::less<>> last_timestamps_;  // latest current times given to entries
+  std::vector<std::thread> senders_;
+};
+
+std::unique_ptr<IBatchWriter> IBatchWriter::Build(const IBucket& bucket, Options options) noexcept {
+  return std::make_unique<BatchWriter>(bucket, options);
+}
+
+std::unique_ptr<IBatchWriter> IBatchWriter::Build(const IBucket& bucket) noexcept {
+  return std::make_unique<BatchWriter>(bucket, Options{});
+}
+
+}  // namespace reduct
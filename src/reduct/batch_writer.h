@@ -0,0 +1,94 @@
+// Copyright 2026 ReductSoftware UG
+
+#ifndef REDUCT_CPP_BATCH_WRITER_H
+#define REDUCT_CPP_BATCH_WRITER_H
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "reduct/bucket.h"
+#include "reduct/error.h"
+
+namespace reduct {
+
+/**
+ * @class IBatchWriter
+ * @brief Collects single records into batches and writes them in the background.
+ *
+ * The records may be written from many threads. They are buffered in a batch which is sent with
+ * IBucket::WriteBatch when it reaches the size or number of records, or when its first record has waited
+ * for the linger time. The result of each record is reported by a completion callback or a future.
+ *
+ * With Options::max_in_flight > 1 the batches are pipelined: the next batches are sent while the server
+ * responds to the previous ones, which keeps a high-latency link busy. The client must have enough connections
+ * (see HttpOptions::max_connections).
+ *
+ * The batches are sent to several entries in one request, so the server must support the batch protocol v2
+ * (API 1.18+) if the records go to different entries.
+ */
+class IBatchWriter {
+ public:
+  /**
+   * Thresholds of a batch
+   */
+  struct Options {
+    size_t max_batch_size = 8'000'000;                       ///< send the batch when its body reaches this size
+    size_t max_batch_records = 1'000;                        ///< send the batch when it has this number of records
+    std::chrono::milliseconds linger = std::chrono::milliseconds(10);  ///< max time a record waits in the batch
+    size_t max_buffer_size = 64'000'000;  ///< max bytes buffered by the writer, Write blocks when it is reached
+    size_t max_in_flight = 1;  ///< batches sent at the same time, each one over its own pooled connection
+    bool keep_order = false;   ///< with max_in_flight > 1, don't send a batch before the previous batches
+                               /// with the same entries are written
+  };
+
+  /**
+   * Called on the thread of the writer with the HTTP error of the batch or the error of the record
+   */
+  using CompletionCallback = std::function<void(Error)>;
+
+  /**
+   * The destructor sends the buffered records and waits for them
+   */
+  virtual ~IBatchWriter() = default;
+
+  /**
+   * Add a record to the current batch
+   * @param entry_name entry in bucket
+   * @param options options with timestamp, labels and content type. If timestamp is nullopt, the current time is used,
+   * it is increased by a microsecond if the previous record of the entry got the same time
+   * @param data data of the record
+   * @param on_complete called when the batch with the record is written
+   */
+  virtual void Write(std::string_view entry_name, const IBucket::WriteOptions& options, std::string data,
+                     CompletionCallback on_complete) noexcept = 0;
+
+  std::future<Error> Write(std::string_view entry_name, const IBucket::WriteOptions& options,
+                           std::string data) noexcept {
+    auto promise = std::make_shared<std::promise<Error>>();
+    auto future = promise->get_future();
+    Write(entry_name, options, std::move(data), [promise](Error err) { promise->set_value(std::move(err)); });
+    return future;
+  }
+
+  /**
+   * Send the buffered records and wait until all the batches are written
+   */
+  virtual void Flush() noexcept = 0;
+
+  /**
+   * @brief Creates a new batch writer
+   * @param bucket bucket to write, it must exist until the writer is destroyed
+   * @param options thresholds of batches
+   * @return a pointer to the writer
+   */
+  static std::unique_ptr<IBatchWriter> Build(const IBucket& bucket, Options options) noexcept;
+  static std::unique_ptr<IBatchWriter> Build(const IBucket& bucket) noexcept;
+};
+
+}  // namespace reduct
+
+#endif  // REDUCT_CPP_BATCH_WRITER_H
@@ -3,27 +3,29 @@
 #include "reduct/bucket.h"
 #define FMT_HEADER_ONLY 1
 #include <fmt/core.h>
-#ifdef CONCURRENTQUEUE_H_FILEPATH
-#include CONCURRENTQUEUE_H_FILEPATH
-#else
-#include <moodycamel/concurrentqueue.h>
-#endif
 
 #include <nlohmann/json.hpp>
 
-#include <atomic>
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <functional>
 #include <future>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <set>
-#include <thread>
+#include <stop_token>
 #include <vector>
 
 #include "reduct/internal/batch_v1.h"
 #include "reduct/internal/batch_v2.h"
+#include "reduct/internal/bucket_factory.h"
+#include "reduct/internal/chunk_queue.h"
+#include "reduct/internal/codec.h"
 #include "reduct/internal/headers.h"
 #include "reduct/internal/http_client.h"
 #include "reduct/internal/serialisation.h"
@@ -39,35 +41,54 @@ class Bucket : public IBucket {
 
  public:
   Bucket(std::string_view url, std::string_view name, const HttpOptions& options,
-         std::optional<std::string> api_version = std::nullopt)
-      : path_(fmt::format("/b/{}", name)), io_path_(fmt::format("/io/{}", name)), stop_{} {
-    name_ = name;
+         std::optional<std::string> api_version = std::nullopt, std::shared_ptr<IExecutor> executor = nullptr,
+         std::shared_ptr<IExecutor> io_executor = nullptr)
+      : name_(name),
+        path_(fmt::format("/b/{}", name)),
+        io_path_(fmt::format("/io/{}", name)),
+        executor_(std::move(executor)),
+        io_executor_(std::move(io_executor)),
+        batch_limits_(options.batch_limits) {
     client_ = IHttpClient::Build(url, options);
     if (api_version) {
       client_->SetApiVersion(api_version);
     }
 
-    worker_ = std::thread([this] {
-      while (!stop_) {
-        Task task;
-        if (task_queue_.try_dequeue(task)) {
-          task();
-        } else {
-          std::this_thread::sleep_for(std::chrono::microseconds(100));
-        }
-      }
-    });
+    if (!executor_) {
+      executor_ = IExecutor::Build();
+    }
+
+    if (!io_executor_) {
+      io_executor_ = IExecutor::Build(options.max_connections);
+    }
   }
 
-  ~Bucket() override {
-    stop_ = true;
-    if (worker_.joinable()) {
-      worker_.join();
+  Bucket(std::string_view name, std::shared_ptr<IHttpClient> client, std::shared_ptr<IExecutor> executor,
+         std::shared_ptr<IExecutor> io_executor, BatchLimits batch_limits)
+      : client_(std::move(client)),
+        name_(name),
+        path_(fmt::format("/b/{}", name)),
+        io_path_(fmt::format("/io/{}", name)),
+        executor_(std::move(executor)),
+        io_executor_(std::move(io_executor)),
+        batch_limits_(batch_limits) {
+    if (!executor_) {
+      executor_ = IExecutor::Build();
+    }
+
+    if (!io_executor_) {
+      io_executor_ = IExecutor::Build(HttpOptions{}.max_connections);
     }
   }
 
+  ~Bucket() override {
+    // the asynchronous operations use the bucket
+    std::unique_lock lock(pending_mutex_);
+    pending_cv_.wait(lock, [this] { return pending_operations_ == 0; });
+  }
+
   Result<Settings> GetSettings() const noexcept override {
-    auto [body, err] = client_->Get(path_);
+    auto [body, err] = client_->Get(Path());
     if (err) {
       return {{}, std::move(err)};
     }
@@ -81,11 +102,11 @@ class Bucket : public IBucket {
   }
 
   Error UpdateSettings(const Settings& settings) const noexcept override {
-    return client_->Put(path_, internal::BucketSettingToJsonString(settings).dump());
+    return client_->Put(Path(), internal::BucketSettingToJsonString(settings).dump());
   }
 
   Result<BucketInfo> GetInfo() const noexcept override {
-    auto [body, err] = client_->Get(path_);
+    auto [body, err] = client_->Get(Path());
     if (err) {
       return {{}, std::move(err)};
     }
@@ -110,7 +131,7 @@ class Bucket : public IBucket {
   }
 
   Result<std::vector<EntryInfo>> GetEntryList() const noexcept override {
-    auto [body, err] = client_->Get(path_);
+    auto [body, err] = client_->Get(Path());
     if (err) {
       return {{}, std::move(err)};
     }
@@ -137,14 +158,14 @@ class Bucket : public IBucket {
     }
   }
 
-  Error Remove() const noexcept override { return client_->Delete(path_); }
+  Error Remove() const noexcept override { return client_->Delete(Path()); }
 
   Error RemoveEntry(std::string_view entry_name) const noexcept override {
-    return client_->Delete(fmt::format("{}/{}", path_, entry_name));
+    return client_->Delete(fmt::format("{}/{}", Path(), entry_name));
   }
 
   Error RemoveRecord(std::string_view entry_name, Time timestamp) const noexcept override {
-    return client_->Delete(fmt::format("{}/{}?ts={}", path_, entry_name, internal::ToMicroseconds(timestamp)));
+    return client_->Delete(fmt::format("{}/{}?ts={}", Path(), entry_name, internal::ToMicroseconds(timestamp)));
   }
 
   Error Write(std::string_view entry_name, std::optional<Time> ts,
@@ -162,7 +183,11 @@ class Bucket : public IBucket {
     const auto content_type = options.content_type.empty() ? "application/octet-stream" : options.content_type;
 
     IHttpClient::Headers headers = MakeHeadersFromLabels(options);
-    return client_->Post(fmt::format("{}/{}?ts={}", path_, entry_name, time), content_type, record.content_length_,
+    if (options.compression != Compression::kNone && record.content_length_ > 0) {
+      CompressRecord(&record, options.compression, &headers);
+    }
+
+    return client_->Post(fmt::format("{}/{}?ts={}", Path(), entry_name, time), content_type, record.content_length_,
                          std::move(headers), std::move(record.callback_));
   }
 
@@ -201,7 +226,8 @@ class Bucket : public IBucket {
       timestamp += std::chrono::microseconds(1);
     }
 
-    auto [errors, err] = internal::ProcessBatchV2Records(client_.get(), io_path_, std::move(batch), BatchType::kWrite);
+    auto [errors, err] = internal::ProcessBatchV2Records(client_.get(), IoPath(), std::move(batch), BatchType::kWrite,
+                                                        batch_limits_, io_executor_.get());
     if (err) {
       return err;
     }
@@ -287,8 +313,8 @@ class Bucket : public IBucket {
       return query_err;
     }
 
-    auto [errors, err] =
-        internal::ProcessBatchV2Records(client_.get(), io_path_, std::move(remove_batch), BatchType::kUpdate);
+    auto [errors, err] = internal::ProcessBatchV2Records(client_.get(), IoPath(), std::move(remove_batch),
+                                                         BatchType::kUpdate, batch_limits_, io_executor_.get());
     if (err) {
       return err;
     }
@@ -311,32 +337,81 @@ class Bucket : public IBucket {
 
     const auto time = internal::ToMicroseconds(*options.timestamp);
     IHttpClient::Headers headers = MakeHeadersFromLabels(options);
-    return client_->Patch(fmt::format("{}/{}?ts={}", path_, entry_name, time), "", std::move(headers));
+    return client_->Patch(fmt::format("{}/{}?ts={}", Path(), entry_name, time), "", std::move(headers));
+  }
+
+  void WriteAsync(std::string_view entry_name, const WriteOptions& options, WriteRecordCallback callback,
+                  CompletionCallback on_complete) const noexcept override {
+    SubmitAsync<Error>(
+        [this, entry_name = std::string(entry_name), options, callback = std::move(callback)] {
+          return Write(entry_name, options, callback);
+        },
+        std::move(on_complete));
+  }
+
+  void WriteBatchAsync(std::string_view entry_name, BatchCallback callback,
+                       BatchCompletionCallback on_complete) const noexcept override {
+    SubmitAsync<Result<BatchErrors>>(
+        [this, entry_name = std::string(entry_name), callback = std::move(callback)] {
+          return WriteBatch(entry_name, callback);
+        },
+        std::move(on_complete));
+  }
+
+  void ReadAsync(std::string_view entry_name, std::optional<Time> ts, ReadRecordCallback callback,
+                 CompletionCallback on_complete) const noexcept override {
+    SubmitAsync<Error>(
+        [this, entry_name = std::string(entry_name), ts, callback = std::move(callback)] {
+          return Read(entry_name, ts, callback);
+        },
+        std::move(on_complete));
+  }
+
+  void QueryAsync(std::string_view entry_name, std::optional<Time> start, std::optional<Time> stop,
+                  QueryOptions options, ReadRecordCallback callback,
+                  CompletionCallback on_complete) const noexcept override {
+    SubmitAsync<Error>(
+        [this, entry_name = std::string(entry_name), start, stop, options = std::move(options),
+         callback = std::move(callback)] { return Query(entry_name, start, stop, options, callback); },
+        std::move(on_complete));
   }
 
   Error Read(std::string_view entry_name, std::optional<Time> ts, ReadRecordCallback callback) const noexcept override {
-    auto path = fmt::format("{}/{}", path_, entry_name);
+    auto path = fmt::format("{}/{}", Path(), entry_name);
     if (ts) {
       path.append(fmt::format("?ts={}", internal::ToMicroseconds(*ts)));
     }
 
-    auto record_err = ReadRecord(std::move(path), ReadType::kSingle, false, callback);
+    auto record_err = ReadRecord(std::move(path), ReadType::kSingle, {.inline_callback = executor_->InWorkerThread()},
+                                 internal::DecodeRecords(std::move(callback)));
     return record_err.error;
   }
 
   Error Head(std::string_view entry_name, std::optional<Time> ts, ReadRecordCallback callback) const noexcept override {
-    auto path = fmt::format("{}/{}", path_, entry_name);
+    auto path = fmt::format("{}/{}", Path(), entry_name);
     if (ts) {
       path.append(fmt::format("?ts={}", internal::ToMicroseconds(*ts)));
     }
 
-    auto record_err = ReadRecord(std::move(path), ReadType::kSingle, true, callback);
+    auto record_err = ReadRecord(std::move(path), ReadType::kSingle,
+                                 {.head_only = true, .inline_callback = executor_->InWorkerThread()}, callback);
     return record_err.error;
   }
 
   Error Query(std::string_view entry_name, std::optional<Time> start, std::optional<Time> stop, QueryOptions options,
               ReadRecordCallback callback) const noexcept override {
+    if (!options.head_only) {
+      callback = internal::DecodeRecords(std::move(callback));
+    }
+
+    // a query started from a record callback can't wait for the executor which runs this callback
+    options.inline_callback = options.inline_callback || executor_->InWorkerThread();
+
     if (SupportsBatchProtocolV2()) {
+      if (options.max_parallel > 1 && !options.continuous) {
+        return QuerySlicedV2(entry_name, start, stop, options, callback);
+      }
+
       const auto entries = std::vector{std::string(entry_name)};
       return QueryV2(entries, start, stop, options, callback);
     }
@@ -344,6 +419,52 @@ class Bucket : public IBucket {
     return QueryV1(entry_name, start, stop, options, callback);
   }
 
+  /**
+   * Split the time interval of a query of one entry into max_parallel slices which are queried in parallel.
+   * An open interval is closed with the oldest and latest records of the entry.
+   */
+  Error QuerySlicedV2(std::string_view entry_name, std::optional<Time> start, std::optional<Time> stop,
+                      const QueryOptions& options, const ReadRecordCallback& callback) const {
+    auto slice_count = options.max_parallel;
+    if (!start || !stop) {
+      auto [entries, err] = GetEntryList();
+      if (err) {
+        return err;
+      }
+
+      auto entry = std::find_if(entries.begin(), entries.end(),
+                                [entry_name](const auto& info) { return info.name == entry_name; });
+      if (entry == entries.end() || entry->record_count == 0) {
+        // nothing to split, the server reports a missing entry
+        return QueryV2({std::string(entry_name)}, start, stop, options, callback);
+      }
+
+      start = start.value_or(entry->oldest_record);
+      stop = stop.value_or(entry->latest_record + std::chrono::microseconds(1));
+      slice_count = std::min<size_t>(slice_count, entry->record_count);
+    }
+
+    const auto span = std::chrono::duration_cast<std::chrono::microseconds>(*stop - *start).count();
+    if (span <= 0) {
+      return QueryV2({std::string(entry_name)}, start, stop, options, callback);
+    }
+
+    // the slices are [start, stop) intervals of the same length which cover the whole interval
+    slice_count = std::min<size_t>(slice_count, span);
+    auto boundary = [&](size_t idx) {
+      const auto count = static_cast<int64_t>(slice_count);
+      const auto i = static_cast<int64_t>(idx);
+      return *start + std::chrono::microseconds(span / count * i + span % count * i / count);
+    };
+
+    std::vector<SubQuery> queries;
+    for (size_t i = 0; i < slice_count; ++i) {
+      queries.push_back({.entries = {std::string(entry_name)}, .start = boundary(i), .stop = boundary(i + 1)});
+    }
+
+    return RunParallelQueries(queries, options, callback);
+  }
+
   Error Query(const std::vector<std::string>& entry_names, std::optional<Time> start, std::optional<Time> stop,
               QueryOptions options, ReadRecordCallback callback) const noexcept override {
     if (!SupportsBatchProtocolV2()) {
@@ -354,6 +475,30 @@ class Bucket : public IBucket {
       return Error{.code = -1, .message = "No entry names provided"};
     }
 
+    if (!options.head_only) {
+      callback = internal::DecodeRecords(std::move(callback));
+    }
+
+    options.inline_callback = options.inline_callback || executor_->InWorkerThread();
+
+    if (options.max_parallel > 1 && entry_names.size() > 1 && !options.continuous) {
+      std::vector<SubQuery> queries;
+      if (options.ordered_merge) {
+        // a query of one entry returns its records in timestamp order, so they can be merged
+        for (const auto& entry : entry_names) {
+          queries.push_back({.entries = {entry}, .start = start, .stop = stop});
+        }
+      } else {
+        const auto group_count = std::min(options.max_parallel, entry_names.size());
+        queries.resize(group_count, {.start = start, .stop = stop});
+        for (size_t i = 0; i < entry_names.size(); ++i) {
+          queries[i * group_count / entry_names.size()].entries.push_back(entry_names[i]);
+        }
+      }
+
+      return RunParallelQueries(queries, options, callback);
+    }
+
     return QueryV2(entry_names, start, stop, options, callback);
   }
 
@@ -365,7 +510,7 @@ class Bucket : public IBucket {
       return json_err;
     }
 
-    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/{}/q", path_, entry_name), json_payload.dump());
+    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/{}/q", Path(), entry_name), json_payload.dump());
     if (resp_err) {
       return resp_err;
     }
@@ -380,68 +525,419 @@ class Bucket : public IBucket {
       return Error{.code = -1, .message = ex.what()};
     }
 
-    while (true) {
-      auto [stopped, record_err] = ReadRecord(fmt::format("{}/{}/batch?q={}", path_, entry_name, id),
-                                              ReadType::kBatched, options.head_only, callback);
-
-      if (stopped) {
-        break;
-      }
-
-      if (record_err) {
-        if (record_err.code == 204) {
-          if (options.continuous) {
-            std::this_thread::sleep_for(options.poll_interval);
-            continue;
-          }
-          break;
-        }
+    const auto path = fmt::format("{}/{}/batch?q={}", Path(), entry_name, id);
+    return ReadPages(
+        options,
+        [&](const ReadRecordCallback& page_callback) {
+          return ReadRecord(std::string(path), ReadType::kBatched, options, page_callback);
+        },
+        callback);
+  }
 
-        return record_err;
-      }
+  Error QueryV2(const std::vector<std::string>& entries, std::optional<Time> start, std::optional<Time> stop,
+                QueryOptions options, const ReadRecordCallback& callback) const {
+    auto [id, err] = CreateQueryV2(entries, start, stop, options);
+    if (err) {
+      return err;
     }
 
-    return Error::kOk;
+    return ReadPages(
+        options, [&](const ReadRecordCallback& page_callback) { return ReadRecordV2(id, options, page_callback); },
+        callback);
   }
 
-  Error QueryV2(const std::vector<std::string>& entries, std::optional<Time> start, std::optional<Time> stop,
-                QueryOptions options, const ReadRecordCallback& callback) const {
+  Result<uint64_t> CreateQueryV2(const std::vector<std::string>& entries, std::optional<Time> start,
+                                 std::optional<Time> stop, const QueryOptions& options) const {
     auto [json_payload, json_err] = QueryOptionsToJsonString("QUERY", entries, start, stop, options);
     if (json_err) {
-      return json_err;
+      return {0, json_err};
     }
 
-    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/q", io_path_), json_payload.dump());
+    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/q", IoPath()), json_payload.dump());
     if (resp_err) {
-      return resp_err;
+      return {0, resp_err};
     }
 
-    uint64_t id;
     try {
       auto data = nlohmann::json::parse(resp);
-      id = data["id"];
+      return {data["id"], Error::kOk};
     } catch (const std::exception& ex) {
-      return Error{.code = -1, .message = ex.what()};
+      return {0, Error{.code = -1, .message = ex.what()}};
     }
+  }
 
+  /**
+   * Part of a query which runs in parallel with the other parts
+   */
+  struct SubQuery {
+    std::vector<std::string> entries;
+    std::optional<Time> start;
+    std::optional<Time> stop;
+  };
+
+  /**
+   * Run the sub-queries over up to max_parallel connections and deliver their records to one callback.
+   *
+   * Without ordered_merge, the records go to the callback as they arrive, one at a time. The last record of each
+   * sub-query is held back until the next one arrives, so that only the final record is marked as last.
+   *
+   * With ordered_merge, the pages of each sub-query are buffered and the callback gets the record with the smallest
+   * timestamp among the first records of all sub-queries, so each sub-query must return its records in timestamp
+   * order.
+   *
+   * The first failed sub-query stops the others and its error is returned.
+   */
+  Error RunParallelQueries(const std::vector<SubQuery>& queries, const QueryOptions& options,
+                           const ReadRecordCallback& callback) const {
+    auto sub_options = options;
+    sub_options.max_parallel = 1;
+
+    if (!options.ordered_merge) {
+      std::mutex mutex;
+      bool stopped = false;
+      // the last record of each sub-query is held back, only the last one of all of them is marked as last
+      std::optional<ReadableRecord> held;
+      auto run_query = [&](size_t idx, std::stop_token stop_token) {
+        {
+          std::lock_guard lock(mutex);
+          if (stopped) {
+            return Error::kOk;
+          }
+        }
+
+        // a failed query stops the others
+        auto query_options = sub_options;
+        query_options.stop_token = std::move(stop_token);
+        const auto& query = queries[idx];
+        return QueryV2(query.entries, query.start, query.stop, query_options, [&](const ReadableRecord& record) {
+          std::lock_guard lock(mutex);
+          if (stopped) {
+            return false;
+          }
+
+          if (!record.last) {
+            stopped = !callback(record);
+            return !stopped;
+          }
+
+          if (held) {
+            stopped = !callback(*held);
+          }
+          held = CopyRecord(record, options.head_only);
+          held->last = false;
+          return !stopped;
+        });
+      };
+
+      auto err = RunParallel(queries.size(), options.max_parallel, io_executor_.get(), run_query, options.stop_token);
+      if (held && !stopped) {
+        held->last = !err;
+        callback(*held);
+      }
+      return err;
+    }
+
+    return MergeQueries(queries, sub_options, callback);
+  }
+
+  /**
+   * k-way merge of sub-queries by timestamp, the callback runs on the calling thread
+   *
+   * The pages are fetched by tasks on the I/O executor while the callback runs. The calling thread fetches a page
+   * itself if no task has taken it, so the merge doesn't wait for a busy executor.
+   */
+  Error MergeQueries(const std::vector<SubQuery>& queries, const QueryOptions& options,
+                     const ReadRecordCallback& callback) const {
+    struct Cursor {
+      std::optional<uint64_t> id;       // created with the first page
+      std::deque<ReadableRecord> page;  // records which wait to be merged
+      bool fetching = false;
+      bool done = false;
+      Error error;
+    };
+
+    std::vector<Cursor> cursors(queries.size());
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopped = false;
+
+    auto needs_page = [](const Cursor& cursor) { return !cursor.done && !cursor.fetching && cursor.page.empty(); };
+
+    // fetches the next page of a cursor without the lock
+    auto fetch_page = [&](Cursor* cursor, std::unique_lock<std::mutex>* lock) {
+      cursor->fetching = true;
+      const auto& query = queries[cursor - cursors.data()];
+      auto id = cursor->id;
+      lock->unlock();
+
+      Error err;
+      if (!id) {
+        auto [new_id, create_err] = CreateQueryV2(query.entries, query.start, query.stop, options);
+        id = new_id;
+        err = create_err;
+      }
+
+      std::deque<ReadableRecord> page;
+      bool last_page = false;
+      if (!err) {
+        // the page must be copied, its records read the response body which is dropped after the page
+        auto [stopped_by_last, read_err] = ReadRecordV2(*id, options, [&page, &options](const auto& record) {
+          page.push_back(CopyRecord(record, options.head_only));
+          return true;
+        });
+        last_page = stopped_by_last;
+        err = read_err;
+      }
+
+      lock->lock();
+      cursor->id = id;
+      cursor->fetching = false;
+      cursor->page = std::move(page);
+      if (err.code == 204) {
+        cursor->done = true;
+      } else if (err) {
+        cursor->done = true;
+        cursor->error = std::move(err);
+      } else {
+        cursor->done = last_page;
+      }
+      cv.notify_all();
+    };
+
+    auto fetch = [&]() {
+      std::unique_lock lock(mutex);
+      while (true) {
+        auto cursor = std::find_if(cursors.begin(), cursors.end(), needs_page);
+        if (stopped || std::all_of(cursors.begin(), cursors.end(), [](const auto& c) { return c.done; })) {
+          return;
+        }
+
+        if (cursor == cursors.end()) {
+          cv.wait(lock);
+          continue;
+        }
+
+        fetch_page(&*cursor, &lock);
+      }
+    };
+
+    // the calling thread is one of the fetchers
+    TaskGroup fetchers(io_executor_.get());
+    for (size_t i = 1; i < std::min(options.max_parallel, queries.size()); ++i) {
+      fetchers.Submit(fetch);
+    }
+
+    Error err;
+    std::unique_lock lock(mutex);
     while (true) {
-      auto [stopped, record_err] = ReadRecordV2(id, options.head_only, callback);
+      // every sub-query must have its next record or be done to find the smallest timestamp
+      while (!std::all_of(cursors.begin(), cursors.end(), [](const auto& c) { return c.done || !c.page.empty(); })) {
+        if (auto cursor = std::find_if(cursors.begin(), cursors.end(), needs_page); cursor != cursors.end()) {
+          fetch_page(&*cursor, &lock);
+        } else {
+          cv.wait(lock);
+        }
+      }
 
-      if (stopped) {
+      auto failed = std::find_if(cursors.begin(), cursors.end(), [](const auto& c) { return bool(c.error); });
+      if (failed != cursors.end()) {
+        err = failed->error;
+        break;
+      }
+
+      Cursor* next = nullptr;
+      for (auto& cursor : cursors) {
+        if (!cursor.page.empty() && (!next || cursor.page.front().timestamp < next->page.front().timestamp)) {
+          next = &cursor;
+        }
+      }
+
+      if (!next) {
+        break;
+      }
+
+      auto record = std::move(next->page.front());
+      next->page.pop_front();
+      record.last = std::all_of(cursors.begin(), cursors.end(), [](const auto& c) { return c.done && c.page.empty(); });
+      if (needs_page(*next)) {
+        cv.notify_all();
+      }
+
+      lock.unlock();
+      const bool next_record = callback(record);
+      lock.lock();
+      if (!next_record) {
         break;
       }
+    }
+
+    stopped = true;
+    cv.notify_all();
+    lock.unlock();
+    fetchers.Wait();
+
+    return err;
+  }
+
+  /**
+   * Copy a record of a response with its data, so it can be read after the response
+   */
+  static ReadableRecord CopyRecord(const ReadableRecord& record, bool head) {
+    auto copy = record;
+    auto [data, err] = head ? Result<std::string>{} : record.ReadAll();
+    copy.Read = [data = std::make_shared<const std::string>(std::move(data)), err](auto read_callback) {
+      if (!data->empty()) {
+        read_callback(*data);
+      }
+      return err;
+    };
+    return copy;
+  }
+
+  using PageReader = std::function<Result<bool>(const ReadRecordCallback&)>;
+
+  /**
+   * Read the pages of a query and pass their records to the callback.
+   *
+   * With QueryOptions::prefetch_pages, a task on the I/O executor reads the next pages into memory while
+   * the callback processes the current one on the calling thread, so the requests of the pages don't wait for
+   * the callback. A query on a thread of the I/O executor reads its pages itself, it can't wait for a task
+   * of its own executor.
+   */
+  Error ReadPages(const QueryOptions& options, const PageReader& read_page, const ReadRecordCallback& callback) const {
+    if (options.prefetch_pages == 0 || io_executor_->InWorkerThread()) {
+      return PollQuery(options, [&] { return read_page(callback); });
+    }
+
+    struct Page {
+      std::vector<ReadableRecord> records;
+      size_t size;
+    };
 
-      if (record_err) {
-        if (record_err.code == 204) {
-          if (options.continuous) {
-            std::this_thread::sleep_for(options.poll_interval);
-            continue;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Page> pages;
+    size_t buffered_size = 0;
+    bool stopped = false;
+    bool read = false;
+    const auto max_buffer_size = options.max_buffer_size.value_or(std::numeric_limits<size_t>::max());
+
+    Error err;
+    TaskGroup reader(io_executor_.get());
+    reader.Submit([&] {
+      err = PollQuery(options, [&]() -> Result<bool> {
+        {
+          // a page is read when there is room for it, the first page is always read
+          std::unique_lock lock(mutex);
+          cv.wait(lock, [&] {
+            return stopped || pages.empty() ||
+                   (pages.size() < options.prefetch_pages && buffered_size < max_buffer_size);
+          });
+          if (stopped) {
+            return {true, Error::kOk};
           }
-          break;
         }
 
+        Page page{.size = 0};
+        auto result = read_page([&page, &options](const ReadableRecord& record) {
+          page.records.push_back(CopyRecord(record, options.head_only));
+          page.size += record.size;
+          return true;
+        });
+
+        if (!page.records.empty()) {
+          std::lock_guard lock(mutex);
+          buffered_size += page.size;
+          pages.push_back(std::move(page));
+          cv.notify_all();
+        }
+        return result;
+      });
+
+      std::lock_guard lock(mutex);
+      read = true;
+      cv.notify_all();
+    });
+
+    std::unique_lock lock(mutex);
+    while (true) {
+      cv.wait(lock, [&] { return !pages.empty() || read; });
+      if (pages.empty()) {
+        break;
+      }
+
+      auto page = std::move(pages.front());
+      pages.pop_front();
+      buffered_size -= page.size;
+      cv.notify_all();
+      lock.unlock();
+
+      const bool next_page = std::all_of(page.records.begin(), page.records.end(),
+                                         [&callback](const auto& record) { return callback(record); });
+
+      lock.lock();
+      if (!next_page || options.stop_token.stop_requested()) {
+        break;
+      }
+    }
+
+    stopped = true;
+    cv.notify_all();
+    lock.unlock();
+    reader.Wait();
+    return err;
+  }
+
+  /**
+   * Read the pages of a query until it is stopped by the callback or QueryOptions::stop_token or has no more records.
+   *
+   * A continuous query polls again right after a page with records. When the server has no new records,
+   * it waits min_poll_interval and doubles the wait with each empty poll up to poll_interval.
+   */
+  static Error PollQuery(const QueryOptions& options, const std::function<Result<bool>()>& read_page) {
+    const auto min_wait = std::min(options.min_poll_interval.value_or(options.poll_interval), options.poll_interval);
+    auto wait = min_wait;
+    while (!options.stop_token.stop_requested()) {
+      if (options.stats) {
+        options.stats->polls++;
+      }
+
+      auto [stopped, record_err] = read_page();
+      if (stopped) {
+        break;
+      }
+
+      if (!record_err) {
+        wait = min_wait;
+        continue;
+      }
+
+      if (record_err.code != 204) {
         return record_err;
       }
+
+      if (options.stats) {
+        options.stats->empty_polls++;
+      }
+
+      if (!options.continuous) {
+        break;
+      }
+
+      const auto started = std::chrono::steady_clock::now();
+      {
+        // the wait ends early if the query is stopped
+        std::mutex mutex;
+        std::condition_variable_any cv;
+        std::unique_lock lock(mutex);
+        cv.wait_for(lock, options.stop_token, wait, [] { return false; });
+      }
+      if (options.stats) {
+        options.stats->poll_wait_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                                           std::chrono::steady_clock::now() - started)
+                                           .count();
+      }
+      wait = std::min(std::max(wait * 2, std::chrono::milliseconds(1)), options.poll_interval);
     }
 
     return Error::kOk;
@@ -478,7 +974,7 @@ class Bucket : public IBucket {
       return {0, std::move(json_err)};
     }
 
-    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/{}/q", path_, entry_name), json_payload.dump());
+    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/{}/q", Path(), entry_name), json_payload.dump());
     if (resp_err) {
       return {0, std::move(resp_err)};
     }
@@ -503,7 +999,7 @@ class Bucket : public IBucket {
       return {0, Error{.code = -1, .message = "At least one entry name is required"}};
     }
 
-    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/q", io_path_), json_payload.dump());
+    auto [resp, resp_err] = client_->PostWithResponse(fmt::format("{}/q", IoPath()), json_payload.dump());
     if (resp_err) {
       return {0, std::move(resp_err)};
     }
@@ -519,16 +1015,19 @@ class Bucket : public IBucket {
   Error RenameEntry(std::string_view old_name, std::string_view new_name) const noexcept override {
     nlohmann::json data;
     data["new_name"] = new_name;
-    return client_->Put(fmt::format("{}/{}/rename", path_, old_name), data.dump());
+    return client_->Put(fmt::format("{}/{}/rename", Path(), old_name), data.dump());
   }
 
   Error Rename(std::string_view new_name) noexcept override {
     nlohmann::json data;
     data["new_name"] = new_name;
-    auto err = client_->Put(fmt::format("{}/rename", path_), data.dump());
+    auto err = client_->Put(fmt::format("{}/rename", Path()), data.dump());
     if (err) {
       return err;
     }
+
+    std::lock_guard lock(name_mutex_);
+    name_ = new_name;
     path_ = fmt::format("/b/{}", new_name);
     io_path_ = fmt::format("/io/{}", new_name);
     return Error::kOk;
@@ -542,7 +1041,7 @@ class Bucket : public IBucket {
     }
 
     auto [json_payload, json_err] =
-        internal::QueryLinkOptionsToJsonString(name_, {std::string(entry_name)}, normalized_options);
+        internal::QueryLinkOptionsToJsonString(Name(), {std::string(entry_name)}, normalized_options);
     if (json_err) {
       return {{}, std::move(json_err)};
     }
@@ -582,7 +1081,7 @@ class Bucket : public IBucket {
       return {{}, std::move(normalize_err)};
     }
 
-    auto [json_payload, json_err] = internal::QueryLinkOptionsToJsonString(name_, entries, normalized_options);
+    auto [json_payload, json_err] = internal::QueryLinkOptionsToJsonString(Name(), entries, normalized_options);
     if (json_err) {
       return {{}, std::move(json_err)};
     }
@@ -594,7 +1093,7 @@ class Bucket : public IBucket {
                               : static_cast<int64_t>(normalized_options.record_index);
 
     auto file_name =
-        normalized_options.file_name ? *normalized_options.file_name : fmt::format("{}_{}.bin", name_, selector);
+        normalized_options.file_name ? *normalized_options.file_name : fmt::format("{}_{}.bin", Name(), selector);
     auto [body, err] = client_->PostWithResponse(fmt::format("/links/{}", file_name), json_payload.dump());
     if (err) {
       return {{}, std::move(err)};
@@ -614,171 +1113,286 @@ class Bucket : public IBucket {
     kBatched,
   };
 
-  Result<bool> ReadRecord(std::string&& path, ReadType type, bool head,
+  Result<bool> ReadRecord(std::string&& path, ReadType type, const QueryOptions& options,
                           const ReadRecordCallback& callback) const noexcept {
-    std::deque<std::optional<std::string>> data;
-    std::mutex data_mutex;
+    const bool head = options.head_only;
+    internal::ChunkQueue data(internal::ChunkQueue::kDefaultCapacity,
+                              options.max_buffer_size.value_or(std::numeric_limits<size_t>::max()));
     std::future<void> future;
     bool stopped = false;
+    InlineRecords inline_records(callback, &stopped);
 
-    auto parse_headers_and_receive_data = [&type, &stopped, &data, &data_mutex, &callback, &future, head,
-                                           this](IHttpClient::Headers&& headers) {
+    auto parse_headers_and_receive_data = [&type, &stopped, &data, &callback, &future, &inline_records, &options,
+                                           head, this](IHttpClient::Headers&& headers) {
       std::vector<ReadableRecord> records;
+      bool sized = true;
       if (type == ReadType::kBatched) {
-        records = internal::ParseAndBuildBatchedRecordsV1(&data, &data_mutex, head, std::move(headers));
+        records = internal::ParseAndBuildBatchedRecordsV1(&data, head, std::move(headers));
       } else {
-        records.emplace_back(ParseAndBuildSingleRecord(&data, &data_mutex, head, std::move(headers)));
+        sized = headers.contains("content-length");
+        records.emplace_back(ParseAndBuildSingleRecord(&data, head, std::move(headers)));
       }
-      for (auto& record : records) {
-        Task task([record = std::move(record), &callback, &stopped] {
-          if (stopped) {
-            return;
-          }
-          stopped = !callback(record);
-          if (!stopped) {
-            stopped = record.last;
-          }
-        });
 
-        future = task.get_future();
-        task_queue_.enqueue(std::move(task));
+      if (options.inline_callback) {
+        inline_records.Start(std::move(records), head, sized);
+      } else {
+        future = SubmitRecords(std::move(records), callback, &stopped, &data);
       }
     };
 
+    IHttpClient::Headers request_headers;
+    if (type == ReadType::kSingle) {
+      // the size of a single record is the content length, which would be the size of the compressed data
+      request_headers.emplace("Accept-Encoding", "identity");
+    }
+
     Error err;
     if (head) {
-      auto ret = client_->Head(path);
+      auto ret = client_->Head(path, std::move(request_headers));
       if (ret.error) {
         err = ret.error;
       } else {
         parse_headers_and_receive_data(std::move(ret.result));
       }
     } else {
-      err = client_->Get(path, parse_headers_and_receive_data, [&data, &data_mutex](auto chunk) {
-        {
-          std::lock_guard lock(data_mutex);
-          data.emplace_back(std::string(chunk));
-        }
-        return true;
-      });
-    }
-
-    if (!err) {
-      if (!head) {
-        // we use nullptr to indicate the end of the stream
-        std::lock_guard lock(data_mutex);
-        data.emplace_back(std::nullopt);
-      }
+      err = client_->Get(path, std::move(request_headers), parse_headers_and_receive_data,
+                         [&data, &inline_records, &options](auto chunk) {
+                           if (options.stop_token.stop_requested()) {
+                             return false;
+                           }
 
-      if (future.valid()) {
-        future.wait();
+                           if (options.inline_callback) {
+                             inline_records.Push(chunk);
+                           } else {
+                             data.Push(chunk);
+                           }
+                           return true;
+                         });
+      if (options.inline_callback && !err && !options.stop_token.stop_requested()) {
+        inline_records.Finish();
       }
     }
 
+    // the records keep a pointer to the queue, so we must wait for them even if the transfer failed
+    FinishTransfer(&data, &future, options);
+    if (options.stop_token.stop_requested()) {
+      return {true, Error::kOk};
+    }
     return {stopped, err};
   }
 
-  Result<bool> ReadRecordV2(uint64_t query_id, bool head, const ReadRecordCallback& callback) const noexcept {
-    std::deque<std::optional<std::string>> data;
-    std::mutex data_mutex;
+  Result<bool> ReadRecordV2(uint64_t query_id, const QueryOptions& options,
+                            const ReadRecordCallback& callback) const noexcept {
+    const bool head = options.head_only;
+    internal::ChunkQueue data(internal::ChunkQueue::kDefaultCapacity,
+                              options.max_buffer_size.value_or(std::numeric_limits<size_t>::max()));
     std::future<void> future;
     bool stopped = false;
+    InlineRecords inline_records(callback, &stopped);
 
     IHttpClient::Headers request_headers;
     request_headers.emplace(std::string(internal::kHeaderQueryId), std::to_string(query_id));
 
-    auto parse_headers_and_receive_data = [&stopped, &data, &data_mutex, &callback, &future, head,
+    auto parse_headers_and_receive_data = [&stopped, &data, &callback, &future, &inline_records, head, &options,
                                            this](IHttpClient::Headers&& headers) {
-      auto records = internal::ParseAndBuildBatchedRecordsV2(&data, &data_mutex, head, std::move(headers));
-      for (auto& record : records) {
-        Task task([record = std::move(record), &callback, &stopped] {
-          if (stopped) {
-            return;
-          }
-          stopped = !callback(record);
-          if (!stopped) {
-            stopped = record.last;
-          }
-        });
-
-        future = task.get_future();
-        task_queue_.enqueue(std::move(task));
+      auto records = internal::ParseAndBuildBatchedRecordsV2(&data, head, std::move(headers), options.share_labels);
+      if (options.inline_callback) {
+        inline_records.Start(std::move(records), head);
+      } else {
+        future = SubmitRecords(std::move(records), callback, &stopped, &data);
       }
     };
 
     Error err;
     if (head) {
-      auto ret = client_->Head(fmt::format("{}/read", io_path_), std::move(request_headers));
+      auto ret = client_->Head(fmt::format("{}/read", IoPath()), std::move(request_headers));
       if (ret.error) {
         err = ret.error;
       } else {
         parse_headers_and_receive_data(std::move(ret.result));
       }
     } else {
-      err = client_->Get(fmt::format("{}/read", io_path_), std::move(request_headers), parse_headers_and_receive_data,
-                         [&data, &data_mutex](auto chunk) {
-                           {
-                             std::lock_guard lock(data_mutex);
-                             data.emplace_back(std::string(chunk));
+      err = client_->Get(fmt::format("{}/read", IoPath()), std::move(request_headers), parse_headers_and_receive_data,
+                         [&data, &inline_records, &options](auto chunk) {
+                           if (options.stop_token.stop_requested()) {
+                             return false;
+                           }
+
+                           if (options.inline_callback) {
+                             inline_records.Push(chunk);
+                           } else {
+                             data.Push(chunk);
                            }
                            return true;
                          });
     }
 
-    if (!err) {
-      if (!head) {
-        std::lock_guard lock(data_mutex);
-        data.emplace_back(std::nullopt);
-      }
-
-      if (future.valid()) {
-        future.wait();
-      }
+    FinishTransfer(&data, &future, options);
+    if (options.stop_token.stop_requested()) {
+      return {true, Error::kOk};
     }
-
     return {stopped, err};
   }
 
-  static ReadableRecord ParseAndBuildSingleRecord(std::deque<std::optional<std::string>>* data, std::mutex* mutex,
-                                                  bool head, IHttpClient::Headers&& headers) {
-    ReadableRecord record;
+  static void FinishTransfer(internal::ChunkQueue* data, std::future<void>* future, const QueryOptions& options) {
+    data->Close();
+    if (future->valid()) {
+      future->wait();
+    }
 
-    record.timestamp = internal::FromMicroseconds(headers[std::string(internal::kHeaderTime)]);
-    record.size = std::stoi(headers["content-length"]);
-    record.content_type = headers["content-type"];
-    record.last = headers[std::string(internal::kHeaderLast)] == "1";
+    if (options.stats) {
+      options.stats->blocked_us += data->BlockedTime().count();
+    }
+  }
 
-    for (const auto& [key, value] : headers) {
-      if (key.starts_with(internal::kHeaderLabelPrefix)) {
-        record.labels.emplace(std::string(key.substr(internal::kHeaderLabelPrefix.size())), value);
+  /**
+   * Runs the callback for the records of a response on the receiving thread, each one as soon as its data is received.
+   * The data of a record is a view of the received chunk, or a copy if the record is split between chunks.
+   * A single record without the content length gets the whole body when the transfer is finished.
+   */
+  class InlineRecords {
+   public:
+    InlineRecords(const ReadRecordCallback& callback, bool* stopped) : callback_(callback), stopped_(stopped) {}
+
+    /**
+     * @param sized false if the response has one record of unknown size, which is read to the end of the body
+     */
+    void Start(std::vector<ReadableRecord> records, bool head, bool sized = true) {
+      records_ = std::move(records);
+      sized_ = sized;
+      if (head) {
+        // no body, the records read nothing
+        for (; next_ < records_.size() && !*stopped_; ++next_) {
+          Deliver({});
+        }
+      } else if (sized_) {
+        DeliverEmpty();
       }
     }
 
-    record.Read = [data, mutex, head](auto record_callback) {
-      if (head) {
-        return Error::kOk;
+    void Push(std::string_view chunk) {
+      if (!sized_) {
+        pending_.append(chunk);
+        return;
       }
 
-      while (true) {
-        std::optional<std::string> chunk = "";
-        {
-          std::lock_guard lock(*mutex);
-          if (!data->empty()) {
-            chunk = std::move(data->front());
-            data->pop_front();
+      while (!chunk.empty() && next_ < records_.size() && !*stopped_) {
+        const auto missing = records_[next_].size - pending_.size();
+        if (pending_.empty() && chunk.size() >= missing) {
+          Deliver(chunk.substr(0, missing));
+        } else {
+          pending_.append(chunk.substr(0, missing));
+          if (pending_.size() < records_[next_].size) {
+            return;
           }
+          Deliver(pending_);
+          pending_.clear();
         }
 
-        if (!chunk) {
-          break;
+        chunk.remove_prefix(std::min(missing, chunk.size()));
+        ++next_;
+        DeliverEmpty();
+      }
+    }
+
+    /**
+     * Deliver the record of unknown size after the whole body is received
+     */
+    void Finish() {
+      if (sized_ || next_ >= records_.size() || *stopped_) {
+        return;
+      }
+
+      records_[next_].size = pending_.size();
+      Deliver(pending_);
+      ++next_;
+    }
+
+   private:
+    void Deliver(std::string_view data) {
+      auto& record = records_[next_];
+      record.Read = [data](const auto& read_callback) {
+        if (!data.empty()) {
+          read_callback(data);
         }
+        return Error::kOk;
+      };
 
-        if (chunk->empty()) {
-          std::this_thread::sleep_for(std::chrono::microseconds(100));
-          continue;
+      *stopped_ = !callback_(record) || record.last;
+    }
+
+    void DeliverEmpty() {
+      for (; next_ < records_.size() && records_[next_].size == 0 && !*stopped_; ++next_) {
+        Deliver({});
+      }
+    }
+
+    const ReadRecordCallback& callback_;
+    bool* stopped_;
+    std::vector<ReadableRecord> records_;
+    bool sized_ = true;
+    size_t next_ = 0;       // record which waits for its data
+    std::string pending_;  // data of the next record received in previous chunks
+  };
+
+  /**
+   * Runs the callback for all records of a response on the executor.
+   * The records are processed in one task, so they keep their order even if the executor has many threads.
+   * When the task is done, the rest of the response body is dropped.
+   */
+  std::future<void> SubmitRecords(std::vector<ReadableRecord> records, const ReadRecordCallback& callback,
+                                  bool* stopped, internal::ChunkQueue* data) const {
+    if (records.empty()) {
+      data->Cancel();
+      return {};
+    }
+
+    IExecutor::Task task([records = std::move(records), &callback, stopped, data] {
+      for (const auto& record : records) {
+        if (*stopped) {
+          break;
+        }
+        *stopped = !callback(record);
+        if (!*stopped) {
+          *stopped = record.last;
         }
+      }
+
+      data->Cancel();
+    });
 
-        if (!record_callback(std::move(*chunk))) {
+    auto future = task.get_future();
+    executor_->Submit(std::move(task));
+    return future;
+  }
+
+  static ReadableRecord ParseAndBuildSingleRecord(internal::ChunkQueue* data, bool head,
+                                                  IHttpClient::Headers&& headers) {
+    ReadableRecord record;
+
+    record.timestamp = internal::FromMicroseconds(headers[std::string(internal::kHeaderTime)]).value_or(Time());
+    // a response without the content length is read to the end, its size is unknown
+    const auto& length = headers["content-length"];
+    record.size = 0;
+    std::from_chars(length.data(), length.data() + length.size(), record.size);
+    record.content_type = headers["content-type"];
+    record.last = headers[std::string(internal::kHeaderLast)] == "1";
+
+    for (const auto& [key, value] : internal::HeadersWithPrefix(headers, internal::kHeaderLabelPrefix)) {
+      // the header names are kept as received, but the label names are lowercase as in the other clients
+      auto name = key.substr(internal::kHeaderLabelPrefix.size());
+      std::transform(name.begin(), name.end(), name.begin(), internal::HeaderNameLess::ToLower);
+      record.labels.emplace(std::move(name), value);
+    }
+
+    record.Read = [data, head](auto record_callback) {
+      if (head) {
+        return Error::kOk;
+      }
+
+      while (auto chunk = data->Front()) {
+        data->Consume(chunk->size());
+        if (!record_callback(*chunk)) {
           break;
         }
       }
@@ -788,6 +1402,32 @@ class Bucket : public IBucket {
     return record;
   }
 
+  /**
+   * Replace the data of a record with the compressed data and tag it with the encoding label.
+   * The data is collected from the write callback, because the size of the compressed data must be known.
+   */
+  static void CompressRecord(WritableRecord* record, Compression compression, IHttpClient::Headers* headers) {
+    auto data = std::make_shared<std::string>();
+    data->reserve(record->content_length_);
+    while (data->size() < record->content_length_) {
+      auto [ok, chunk] = record->callback_(data->size(), record->content_length_ - data->size());
+      if (!ok || chunk.empty()) {
+        // the writer stopped, the request is aborted as without compression
+        record->callback_ = [](auto, auto) { return std::pair<bool, std::string_view>{false, ""}; };
+        return;
+      }
+      data->append(chunk);
+    }
+
+    if (auto compressed = internal::CompressRecord(*data, compression)) {
+      *data = std::move(*compressed);
+      headers->insert_or_assign(fmt::format("{}{}", internal::kHeaderLabelPrefix, internal::kEncodingLabel),
+                                std::string(internal::kGzipEncoding));
+    }
+
+    record->WriteAll(std::shared_ptr<const std::string>(std::move(data)));
+  }
+
   IHttpClient::Headers MakeHeadersFromLabels(const WriteOptions& options) const {
     IHttpClient::Headers headers;
     for (const auto& [key, value] : options.labels) {
@@ -870,10 +1510,12 @@ class Bucket : public IBucket {
     callback(&batch);
 
     if (SupportsBatchProtocolV2()) {
-      return internal::ProcessBatchV2(client_.get(), io_path_, entry_name, std::move(batch), type);
+      return internal::ProcessBatchV2(client_.get(), IoPath(), entry_name, std::move(batch), type, batch_limits_,
+                                      io_executor_.get());
     }
 
-    return internal::ProcessBatchV1(client_.get(), path_, entry_name, std::move(batch), type);
+    return internal::ProcessBatchV1(client_.get(), Path(), entry_name, std::move(batch), type, batch_limits_,
+                                    io_executor_.get());
   }
 
   Result<BatchRecordErrors> ProcessBatchV2(BatchCallback callback, BatchType type) const noexcept {
@@ -885,7 +1527,8 @@ class Bucket : public IBucket {
     }
 
     if (SupportsBatchProtocolV2()) {
-      return internal::ProcessBatchV2Records(client_.get(), io_path_, std::move(batch), type);
+      return internal::ProcessBatchV2Records(client_.get(), IoPath(), std::move(batch), type, batch_limits_,
+                                             io_executor_.get());
     }
 
     std::string entry_name;
@@ -900,25 +1543,66 @@ class Bucket : public IBucket {
       return {{}, Error{.code = 400, .message = "Entry name is required"}};
     }
 
-    auto [errors, err] = internal::ProcessBatchV1(client_.get(), path_, entry_name, std::move(batch), type);
-    if (err) {
-      return {{}, err};
-    }
-
+    auto [errors, err] = internal::ProcessBatchV1(client_.get(), Path(), entry_name, std::move(batch), type,
+                                                  batch_limits_, io_executor_.get());
     BatchRecordErrors record_errors;
     record_errors.emplace(std::move(entry_name), std::move(errors));
-    return {record_errors, Error::kOk};
+    return {record_errors, err};
+  }
+
+  /**
+   * Runs an asynchronous operation on the I/O executor, the destructor waits for all of them.
+   * The operation stops being counted before its completion callback, so the callback may destroy the bucket.
+   */
+  template <typename T>
+  void SubmitAsync(std::function<T()> operation, std::function<void(T)> on_complete) const {
+    {
+      std::lock_guard lock(pending_mutex_);
+      ++pending_operations_;
+    }
+
+    io_executor_->Submit(
+        IExecutor::Task([this, operation = std::move(operation), on_complete = std::move(on_complete)] {
+          auto result = operation();
+          {
+            std::lock_guard lock(pending_mutex_);
+            if (--pending_operations_ == 0) {
+              pending_cv_.notify_all();
+            }
+          }
+
+          // the bucket may be gone from here on
+          on_complete(std::move(result));
+        }));
   }
 
-  std::unique_ptr<internal::IHttpClient> client_;
+  // Rename may run concurrently with requests from other threads, so the paths are copied under the lock
+  std::string Name() const {
+    std::lock_guard lock(name_mutex_);
+    return name_;
+  }
+
+  std::string Path() const {
+    std::lock_guard lock(name_mutex_);
+    return path_;
+  }
+
+  std::string IoPath() const {
+    std::lock_guard lock(name_mutex_);
+    return io_path_;
+  }
+
+  std::shared_ptr<internal::IHttpClient> client_;
   std::string name_;
   std::string path_;
   std::string io_path_;
-  std::thread worker_;
-
-  using Task = std::packaged_task<void()>;
-  mutable moodycamel::ConcurrentQueue<Task> task_queue_;
-  std::atomic<bool> stop_;
+  mutable std::mutex name_mutex_;
+  std::shared_ptr<IExecutor> executor_;
+  std::shared_ptr<IExecutor> io_executor_;
+  BatchLimits batch_limits_;
+  mutable size_t pending_operations_ = 0;
+  mutable std::mutex pending_mutex_;
+  mutable std::condition_variable pending_cv_;
 };
 
 std::unique_ptr<IBucket> IBucket::Build(std::string_view server_url, std::string_view name,
@@ -931,6 +1615,22 @@ std::unique_ptr<IBucket> IBucket::Build(std::string_view server_url, std::string
   return std::make_unique<Bucket>(server_url, name, options, std::move(api_version));
 }
 
+std::unique_ptr<IBucket> IBucket::Build(std::string_view server_url, std::string_view name, const HttpOptions& options,
+                                        std::optional<std::string> api_version, std::shared_ptr<IExecutor> executor,
+                                        std::shared_ptr<IExecutor> io_executor) noexcept {
+  return std::make_unique<Bucket>(server_url, name, options, std::move(api_version), std::move(executor),
+                                  std::move(io_executor));
+}
+
+namespace internal {
+std::unique_ptr<IBucket> BuildBucket(std::string_view name, std::shared_ptr<IHttpClient> client,
+                                     std::shared_ptr<IExecutor> executor,
+                                     std::shared_ptr<IExecutor> io_executor, BatchLimits batch_limits) noexcept {
+  return std::make_unique<Bucket>(name, std::move(client), std::move(executor), std::move(io_executor),
+                                  batch_limits);
+}
+}  // namespace internal
+
 // Settings
 std::ostream& operator<<(std::ostream& os, const reduct::IBucket::Settings& settings) {
   os << internal::BucketSettingToJsonString(settings).dump();
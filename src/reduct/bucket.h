@@ -2,17 +2,24 @@
 #ifndef REDUCT_CPP_BUCKET_H
 #define REDUCT_CPP_BUCKET_H
 
+#include <atomic>
 #include <chrono>
+#include <concepts>
 #include <functional>
+#include <future>
 #include <map>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <set>
+#include <stop_token>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "reduct/error.h"
+#include "reduct/executor.h"
 #include "reduct/http_options.h"
 #include "reduct/result.h"
 
@@ -25,6 +32,14 @@ namespace reduct {
  * You can perform operations like getting the bucket settings, updating the settings,
  * getting bucket information, retrieving the list of entries, writing records to the bucket,
  * and reading records from the bucket.
+ *
+ * Thread safety: all the methods may be called concurrently on one bucket from many threads.
+ * Each request takes its own connection from the pool of the client (see HttpOptions::max_connections),
+ * so parallel writes, batches and queries don't wait for each other. Rename may also run concurrently,
+ * requests started before it finishes use the old name.
+ *
+ * A read or query may be started from a record callback of any bucket of the same client. Its callback then
+ * runs on the calling thread, because the callback executor is busy with the outer callback.
  */
 class IBucket {
  public:
@@ -97,6 +112,8 @@ class IBucket {
     bool last;
     LabelMap labels;
     std::string content_type;
+    std::shared_ptr<const LabelMap> shared_labels;  ///< labels shared by the records of a response with the same
+                                                    /// labels, set instead of labels if QueryOptions::share_labels
 
     /**
      * Called when HTTP Client received a chunk with data. It may return false to stop transferring
@@ -104,7 +121,8 @@ class IBucket {
     using ReadCallback = std::function<bool(std::string_view)>;
 
     /**
-     * Function to receive data in chunks
+     * Function to receive data in chunks. The data of a record compressed by the client (see
+     * WriteOptions::compression) is decompressed while it is received, but size is the size of the stored data
      */
     std::function<Error(ReadCallback)> Read;
 
@@ -138,7 +156,14 @@ class IBucket {
      */
     using WriteCallback = std::function<std::pair<bool, std::string>(size_t offset, size_t size)>;
 
-    WriteCallback callback_ = [](auto offset, auto size) { return std::pair{false, ""}; };
+    /**
+     * Called when HTTP Client is ready to send a chunk with data.
+     * @returns pair where first is true to continue sending, false to stop. Second is a view of the data to send,
+     * it may be shorter than the requested size and must be valid until the next call
+     */
+    using WriteViewCallback = std::function<std::pair<bool, std::string_view>(size_t offset, size_t size)>;
+
+    WriteViewCallback callback_ = [](auto offset, auto size) { return std::pair<bool, std::string_view>{false, ""}; };
     size_t content_length_;
 
     /**
@@ -147,6 +172,21 @@ class IBucket {
      * @param cb
      */
     void Write(size_t content_length, WriteCallback&& cb) {
+      content_length_ = content_length;
+      // keep the last chunk alive while the HTTP client sends it
+      callback_ = [cb = std::move(cb), chunk = std::string()](size_t offset, size_t size) mutable {
+        auto [ok, data] = cb(offset, size);
+        chunk = std::move(data);
+        return std::pair<bool, std::string_view>{ok, chunk};
+      };
+    }
+
+    /**
+     * Receives write callback returning views of the data, so it goes to the socket without copying
+     * @param content_length
+     * @param cb
+     */
+    void WriteView(size_t content_length, WriteViewCallback&& cb) {
       content_length_ = content_length;
       callback_ = std::move(cb);
     }
@@ -155,18 +195,36 @@ class IBucket {
      * Sends the whole blob to write
      * @param data
      */
-    void WriteAll(std::string data) {
-      content_length_ = data.size();
+    void WriteAll(std::string data) { WriteAll(std::make_shared<const std::string>(std::move(data))); }
+
+    /**
+     * Sends the whole blob to write without copying, the record keeps the blob alive until it is sent
+     * @param data
+     */
+    void WriteAll(std::shared_ptr<const std::string> data) {
+      content_length_ = data->size();
       callback_ = [data = std::move(data)](size_t offset, size_t size) {
-        return std::pair{true, data.substr(offset, size)};
+        return std::pair{true, std::string_view(*data).substr(offset, size)};
       };
     }
+
+    /**
+     * Sends the whole blob to write without copying
+     * @param data view of the blob, it must be valid until the write call returns
+     */
+    void WriteAllView(std::string_view data) {
+      content_length_ = data.size();
+      callback_ = [data](size_t offset, size_t size) { return std::pair{true, data.substr(offset, size)}; };
+    }
   };
 
   using WriteRecordCallback = std::function<void(WritableRecord*)>;
 
   /**
    * Batch of records
+   *
+   * The data of the records is stored in one contiguous buffer. Clear() keeps the allocated memory,
+   * so a producer may reuse one batch without allocations for the data.
    */
   class Batch {
    public:
@@ -176,29 +234,77 @@ class IBucket {
       size_t size;
       std::string content_type;
       LabelMap labels;
-      std::optional<size_t> data_index;
+      std::optional<size_t> data_offset;  // offset of the data in the buffer of the batch
+      std::optional<size_t> moved_data;   // index of the data moved into the batch, kept apart from the buffer
     };
 
     /**
-     * Add a record to batch
+     * Add a record to batch, the data is copied into the buffer of the batch
      * @param timestamp
      * @param data
      * @param content_type
      * @param labels
      */
-    void AddRecord(Time timestamp, std::string data, std::string content_type = "", LabelMap labels = {}) {
-      AddRecord("", timestamp, std::move(data), std::move(content_type), std::move(labels));
+    void AddRecord(Time timestamp, std::string_view data, std::string content_type = "", LabelMap labels = {}) {
+      AddRecord("", timestamp, data, std::move(content_type), std::move(labels));
     }
 
-    void AddRecord(std::string entry, Time timestamp, std::string data, std::string content_type = "",
+    void AddRecord(std::string entry, Time timestamp, std::string_view data, std::string content_type = "",
                    LabelMap labels = {}) {
-      const auto index = body_.size();
-      body_.push_back(std::move(data));
-      size_ += body_.back().size();
+      const auto offset = body_.size();
+      body_.append(data);
+      size_ += data.size();
       records_.push_back(
-          Record{std::move(entry), timestamp, body_.back().size(), std::move(content_type), std::move(labels), index});
+          Record{std::move(entry), timestamp, data.size(), std::move(content_type), std::move(labels), offset});
+    }
+
+    /**
+     * Add a record to batch, big data is moved into the batch without copying, small data is copied into
+     * the buffer of the batch
+     * @param timestamp
+     * @param data
+     * @param content_type
+     * @param labels
+     */
+    template <typename Data>
+      requires std::same_as<Data, std::string>
+    void AddRecord(Time timestamp, Data&& data, std::string content_type = "", LabelMap labels = {}) {
+      AddRecord("", timestamp, std::move(data), std::move(content_type), std::move(labels));
+    }
+
+    template <typename Data>
+      requires std::same_as<Data, std::string>
+    void AddRecord(std::string entry, Time timestamp, Data&& data, std::string content_type = "",
+                   LabelMap labels = {}) {
+      if (data.size() <= kMaxBufferedSize) {
+        AddRecord(std::move(entry), timestamp, std::string_view(data), std::move(content_type), std::move(labels));
+        return;
+      }
+
+      const auto size = data.size();
+      size_ += size;
+      moved_.push_back(std::move(data));
+      records_.push_back(Record{std::move(entry), timestamp, size, std::move(content_type), std::move(labels),
+                                std::nullopt, moved_.size() - 1});
+    }
+
+    /**
+     * Add a record to batch with compressed data. The record is tagged with the "content-encoding" label and
+     * decompressed by the readers of this SDK. The data is stored as is if it doesn't become smaller.
+     * @param timestamp
+     * @param data
+     * @param compression codec of the data, gzip needs the library built with REDUCT_CPP_ENABLE_COMPRESSION
+     * @param content_type content type of the uncompressed data
+     * @param labels
+     */
+    void AddRecord(Time timestamp, std::string_view data, Compression compression, std::string content_type = "",
+                   LabelMap labels = {}) {
+      AddRecord("", timestamp, data, compression, std::move(content_type), std::move(labels));
     }
 
+    void AddRecord(std::string entry, Time timestamp, std::string_view data, Compression compression,
+                   std::string content_type = "", LabelMap labels = {});
+
     /**
      * Add an empty record to batch (use for removing)
      * @param timestamp
@@ -215,6 +321,26 @@ class IBucket {
       records_.push_back(Record{std::move(entry), timestamp, 0, "", std::move(labels), std::nullopt});
     }
 
+    /**
+     * Reserve memory for records and their data
+     * @param record_count number of records
+     * @param data_size total size of the data
+     */
+    void Reserve(size_t record_count, size_t data_size) {
+      records_.reserve(record_count);
+      body_.reserve(data_size);
+    }
+
+    /**
+     * Remove all records, the allocated memory is kept for the next records
+     */
+    void Clear() noexcept {
+      records_.clear();
+      body_.clear();
+      moved_.clear();
+      size_ = 0;
+    }
+
     [[nodiscard]] const std::vector<Record>& records() const { return records_; }
 
     [[nodiscard]] std::string Slice(size_t offset, size_t size) const { return Slice(std::nullopt, offset, size); }
@@ -224,8 +350,14 @@ class IBucket {
         return "";
       }
 
+      if (!order && moved_.empty()) {
+        // the buffer keeps the data in the order of the records
+        return body_.substr(offset, size);
+      }
+
       std::string result;
-      const auto process_data = [&](const std::string& data) {
+      for (size_t i = 0; i < (order ? order->size() : records_.size()); ++i) {
+        auto data = record_data(order ? (*order)[i] : i);
         if (offset < data.size()) {
           auto n = std::min(size, data.size() - offset);
           result.append(data.substr(offset, n));
@@ -234,36 +366,40 @@ class IBucket {
         } else {
           offset -= data.size();
         }
-      };
 
-      if (order) {
-        for (auto idx : *order) {
-          const auto& record = records_.at(idx);
-          if (!record.data_index) {
-            continue;
-          }
-          process_data(body_.at(*record.data_index));
-          if (size == 0) {
-            break;
-          }
-        }
-      } else {
-        for (const auto& data : body_) {
-          process_data(data);
-          if (size == 0) {
-            break;
-          }
+        if (size == 0) {
+          break;
         }
       }
 
       return result;
     }
 
+    /**
+     * Data of a record
+     * @param index index of the record in records()
+     * @return view of the data, empty if the record has no data
+     */
+    [[nodiscard]] std::string_view record_data(size_t index) const {
+      const auto& record = records_.at(index);
+      if (record.moved_data) {
+        return moved_.at(*record.moved_data);
+      }
+      if (!record.data_offset) {
+        return {};
+      }
+      return std::string_view(body_).substr(*record.data_offset, record.size);
+    }
+
     [[nodiscard]] uint64_t size() const { return size_; }
 
    private:
+    // bigger data moved into the batch is kept as it is
+    static constexpr size_t kMaxBufferedSize = 16'384;
+
     std::vector<Record> records_;
-    std::vector<std::string> body_;
+    std::string body_;                // data of the records copied into the batch one after another
+    std::vector<std::string> moved_;  // data of the big records moved into the batch
     uint64_t size_ = 0;
   };
 
@@ -315,6 +451,7 @@ class IBucket {
     std::optional<Time> timestamp;
     LabelMap labels;
     std::string content_type;
+    Compression compression = Compression::kNone;  ///< compress the data before sending, see Batch::AddRecord
   };
 
   /**
@@ -329,6 +466,12 @@ class IBucket {
 
   /**
    * Write a batch of records in one HTTP request
+   *
+   * The batch is written atomically in one request, unless it is bigger than HttpOptions::batch_limits, which are
+   * unlimited by default. Then it is split into several requests, if one of them fails, the records of the requests
+   * sent before stay written. The method returns the error of the failed request together with the errors of all
+   * the records, the records which weren't written get the error of the request.
+   *
    * @param entry_name entry in bucket
    * @param callback a callback to add records to batch
    * @return HTTP error or map of errors for each record
@@ -338,6 +481,9 @@ class IBucket {
 
   /**
    * Write a batch of records in one HTTP request (targeting multiple entries)
+   *
+   * A split batch reports a failed request like WriteBatch(entry_name, callback).
+   *
    * @param callback a callback to add records to batch
    * @return HTTP error or map of errors for each record
    */
@@ -403,6 +549,18 @@ class IBucket {
   virtual Error RemoveAttachments(std::string_view entry_name, const std::set<std::string>& attachment_keys) const
       noexcept = 0;
 
+  /**
+   * Counters of a query
+   *
+   * Pass a shared instance in QueryOptions to observe a running query from another thread
+   */
+  struct QueryStats {
+    std::atomic<uint64_t> blocked_us = 0;  ///< time the HTTP transfer waited for the callback to read buffered data
+    std::atomic<uint64_t> polls = 0;        ///< requests for the next page of records
+    std::atomic<uint64_t> empty_polls = 0;  ///< requests answered without records
+    std::atomic<uint64_t> poll_wait_us = 0;  ///< time a continuous query waited between empty polls
+  };
+
   /**
    * Query options
    */
@@ -414,11 +572,37 @@ class IBucket {
     bool continuous = false;  ///< continuous query. If true,
                               /// the method returns the latest record and waits for the next one
     std::chrono::milliseconds poll_interval = std::chrono::milliseconds(1000);  ///< poll interval for continuous query
+    std::optional<std::chrono::milliseconds> min_poll_interval;  ///< if set, a continuous query polls adaptively:
+                                                                  /// it waits min_poll_interval after an empty poll,
+                                                                  /// doubles the wait up to poll_interval while idle
+                                                                  /// and polls again right after new records
     bool head_only = false;                                                     ///< read only metadata
+    std::optional<size_t> max_buffer_size;  ///< max bytes of a response buffered while the callback is busy,
+                                            /// if it is reached, the transfer waits for the callback
+    std::shared_ptr<QueryStats> stats;      ///< counters updated by the query, if not null
+    bool share_labels = false;  ///< records get shared_labels instead of a copy of the labels (API 1.18+)
+    size_t max_parallel = 1;    ///< if > 1, a query is split into queries by entries or time slices which run at
+                                /// the same time over separate connections (API 1.18+, not for continuous queries).
+                                /// A limit in the condition applies to each of them
+    size_t prefetch_pages = 0;  ///< if > 0, up to this number of next pages are read into memory while the callback
+                                /// processes the current one on the thread of the query. The pages are also limited
+                                /// by max_buffer_size
+    bool inline_callback = false;  ///< call the callback on the thread which receives the response, as soon as
+                                   /// the data of a record is received, instead of on the executor. The callback
+                                   /// blocks the transfer, so it suits head-only queries and small records
+    bool ordered_merge = true;  ///< with max_parallel > 1, merge the records of the parallel queries by timestamp
+                                /// and call the callback on the thread of the query, otherwise call it as the records
+                                /// arrive, one at a time
+    std::stop_token stop_token;  ///< stops the query from another thread: the transfer of the current page is
+                                 /// dropped and a continuous query doesn't wait for the next poll
   };
 
   /**
    * @brief Query data for a time interval
+   *
+   * With QueryOptions::max_parallel > 1 the interval is split into max_parallel slices of the same length which are
+   * queried at the same time. If the interval is open, it is closed with the oldest and latest records of the entry.
+   *
    * @param entry_name
    * @param start start time point ,if nullopt then from very beginning
    * @param stop stop time point, if nullopt then until the last record
@@ -431,6 +615,11 @@ class IBucket {
 
   /**
    * @brief  Query data for multiple entries for a time interval
+   *
+   * With QueryOptions::max_parallel > 1 the entries are queried over several connections at the same time.
+   * With QueryOptions::ordered_merge, each entry has its own query and their records are merged by timestamp.
+   * Otherwise the entries are split into max_parallel groups and the records come in any order.
+   *
    * @param entry_names
    * @param start start time point ,if nullopt then from very beginning
    * @param stop stop time point, if nullopt then until the last record
@@ -441,6 +630,97 @@ class IBucket {
   [[nodiscard]] virtual Error Query(const std::vector<std::string>& entry_names, std::optional<Time> start,
                                     std::optional<Time> stop, QueryOptions options,
                                     ReadRecordCallback callback) const noexcept = 0;
+
+  /**
+   * Asynchronous API
+   *
+   * The operations are queued to the I/O executor of the bucket and run on its threads over the pooled connections,
+   * so a few threads serve any number of requests in flight. Each operation has two forms: with a completion callback,
+   * which is called on an I/O thread, and with a future. Record callbacks of reads and queries run on the
+   * executor for callbacks as in the synchronous API.
+   *
+   * The bucket waits for its pending operations when destroyed. An operation stops using the bucket before its
+   * completion callback is called, so the callback may destroy the bucket, but the record callbacks may not.
+   */
+  using CompletionCallback = std::function<void(Error)>;
+  using BatchCompletionCallback = std::function<void(Result<BatchErrors>)>;
+
+  /**
+   * Write a record asynchronously
+   * @param entry_name entry in bucket
+   * @param options options with timestamp, labels and content type
+   * @param callback called on an I/O thread to provide the data
+   * @param on_complete called with HTTP or communication error
+   */
+  virtual void WriteAsync(std::string_view entry_name, const WriteOptions& options, WriteRecordCallback callback,
+                          CompletionCallback on_complete) const noexcept = 0;
+
+  std::future<Error> WriteAsync(std::string_view entry_name, const WriteOptions& options,
+                                WriteRecordCallback callback) const noexcept {
+    auto promise = std::make_shared<std::promise<Error>>();
+    auto future = promise->get_future();
+    WriteAsync(entry_name, options, std::move(callback), [promise](Error err) { promise->set_value(std::move(err)); });
+    return future;
+  }
+
+  /**
+   * Write a batch of records asynchronously
+   * @param entry_name entry in bucket
+   * @param callback called on an I/O thread to add records to batch
+   * @param on_complete called with HTTP error or map of errors for each record
+   */
+  virtual void WriteBatchAsync(std::string_view entry_name, BatchCallback callback,
+                               BatchCompletionCallback on_complete) const noexcept = 0;
+
+  std::future<Result<BatchErrors>> WriteBatchAsync(std::string_view entry_name,
+                                                   BatchCallback callback) const noexcept {
+    auto promise = std::make_shared<std::promise<Result<BatchErrors>>>();
+    auto future = promise->get_future();
+    WriteBatchAsync(entry_name, std::move(callback),
+                    [promise](Result<BatchErrors> result) { promise->set_value(std::move(result)); });
+    return future;
+  }
+
+  /**
+   * Read a record asynchronously
+   * @param entry_name entry in bucket
+   * @param ts timestamp, if it is nullopt, the method returns the latest record
+   * @param callback called with the record. To continue receiving it should return true
+   * @param on_complete called with HTTP or communication error
+   */
+  virtual void ReadAsync(std::string_view entry_name, std::optional<Time> ts, ReadRecordCallback callback,
+                         CompletionCallback on_complete) const noexcept = 0;
+
+  std::future<Error> ReadAsync(std::string_view entry_name, std::optional<Time> ts,
+                               ReadRecordCallback callback) const noexcept {
+    auto promise = std::make_shared<std::promise<Error>>();
+    auto future = promise->get_future();
+    ReadAsync(entry_name, ts, std::move(callback), [promise](Error err) { promise->set_value(std::move(err)); });
+    return future;
+  }
+
+  /**
+   * Query data for a time interval asynchronously
+   * @param entry_name entry in bucket
+   * @param start start time point ,if nullopt then from very beginning
+   * @param stop stop time point, if nullopt then until the last record
+   * @param options
+   * @param callback return next record If you want to stop querying, return false
+   * @param on_complete called with HTTP or communication error when the query is finished
+   */
+  virtual void QueryAsync(std::string_view entry_name, std::optional<Time> start, std::optional<Time> stop,
+                          QueryOptions options, ReadRecordCallback callback,
+                          CompletionCallback on_complete) const noexcept = 0;
+
+  std::future<Error> QueryAsync(std::string_view entry_name, std::optional<Time> start, std::optional<Time> stop,
+                                QueryOptions options, ReadRecordCallback callback) const noexcept {
+    auto promise = std::make_shared<std::promise<Error>>();
+    auto future = promise->get_future();
+    QueryAsync(entry_name, start, stop, std::move(options), std::move(callback),
+               [promise](Error err) { promise->set_value(std::move(err)); });
+    return future;
+  }
+
   /**
    * @brief Get settings by HTTP request
    * @return settings or HTTP error
@@ -582,6 +862,21 @@ class IBucket {
                                         const HttpOptions& options) noexcept;
   static std::unique_ptr<IBucket> Build(std::string_view server_url, std::string_view name, const HttpOptions& options,
                                         std::optional<std::string> api_version) noexcept;
+
+  /**
+   * @brief Creates a new bucket which runs record callbacks on a shared executor
+   * @param server_url HTTP url
+   * @param name name of the bucket
+   * @param options HTTP options
+   * @param api_version API version of the server if it is already known
+   * @param executor executor for record callbacks, if nullptr the bucket creates its own one with one thread
+   * @param io_executor executor for asynchronous operations, if nullptr the bucket creates its own one
+   * with HttpOptions::max_connections threads
+   * @return a pointer to the bucket
+   */
+  static std::unique_ptr<IBucket> Build(std::string_view server_url, std::string_view name, const HttpOptions& options,
+                                        std::optional<std::string> api_version, std::shared_ptr<IExecutor> executor,
+                                        std::shared_ptr<IExecutor> io_executor = nullptr) noexcept;
 };
 }  // namespace reduct
 
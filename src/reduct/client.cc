@@ -12,6 +12,7 @@
 #include <stdexcept>
 
 #include "internal/time_parse.h"
+#include "reduct/internal/bucket_factory.h"
 #include "reduct/internal/http_client.h"
 #include "reduct/internal/serialisation.h"
 
@@ -36,8 +37,17 @@ using internal::ParseStatus;
  */
 class Client : public IClient {
  public:
-  explicit Client(std::string_view url, HttpOptions options) : url_(url), options_(std::move(options)) {
+  explicit Client(std::string_view url, HttpOptions options, std::shared_ptr<IExecutor> executor,
+                  std::shared_ptr<IExecutor> io_executor)
+      : url_(url), options_(std::move(options)), executor_(std::move(executor)), io_executor_(std::move(io_executor)) {
     client_ = internal::IHttpClient::Build(url_, options_);
+    if (!executor_) {
+      executor_ = IExecutor::Build();
+    }
+
+    if (!io_executor_) {
+      io_executor_ = IExecutor::Build(options_.max_connections);
+    }
   }
 
   [[nodiscard]] Result<ServerInfo> GetInfo() const noexcept override {
@@ -126,7 +136,7 @@ class Client : public IClient {
       return {{}, std::move(err)};
     }
 
-    return {IBucket::Build(url_, name, options_, client_->ApiVersion()), {}};
+    return {internal::BuildBucket(name, client_, executor_, io_executor_, options_.batch_limits), {}};
   }
 
   [[nodiscard]] UPtrResult<IBucket> CreateBucket(std::string_view name,
@@ -137,7 +147,7 @@ class Client : public IClient {
       return {nullptr, std::move(err)};
     }
 
-    return {IBucket::Build(url_, name, options_, client_->ApiVersion()), {}};
+    return {internal::BuildBucket(name, client_, executor_, io_executor_, options_.batch_limits), {}};
   }
 
   UPtrResult<IBucket> GetOrCreateBucket(std::string_view name, IBucket::Settings settings) const noexcept override {
@@ -428,12 +438,19 @@ class Client : public IClient {
 
  private:
   HttpOptions options_;
-  std::unique_ptr<internal::IHttpClient> client_;
+  std::shared_ptr<internal::IHttpClient> client_;
   std::string url_;
+  std::shared_ptr<IExecutor> executor_;
+  std::shared_ptr<IExecutor> io_executor_;
 };
 
 std::unique_ptr<IClient> IClient::Build(std::string_view url, HttpOptions options) noexcept {
-  return std::make_unique<Client>(url, std::move(options));
+  return std::make_unique<Client>(url, std::move(options), nullptr, nullptr);
+}
+
+std::unique_ptr<IClient> IClient::Build(std::string_view url, HttpOptions options, std::shared_ptr<IExecutor> executor,
+                                        std::shared_ptr<IExecutor> io_executor) noexcept {
+  return std::make_unique<Client>(url, std::move(options), std::move(executor), std::move(io_executor));
 }
 
 }  // namespace reduct
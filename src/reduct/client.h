@@ -13,6 +13,7 @@
 #include "diagnostics.h"
 #include "reduct/bucket.h"
 #include "reduct/error.h"
+#include "reduct/executor.h"
 #include "reduct/http_options.h"
 #include "reduct/result.h"
 
@@ -378,6 +379,18 @@ class IClient {
    * @return
    */
   static std::unique_ptr<IClient> Build(std::string_view url, HttpOptions options = {}) noexcept;
+
+  /**
+   * @brief Build a client which shares executors with all its buckets
+   * @param url URL of React Storage
+   * @param options HTTP options
+   * @param executor executor to run record callbacks, use IExecutor::Build(n) to configure the number of threads
+   * @param io_executor executor to run asynchronous operations of buckets,
+   * if nullptr the client creates one with HttpOptions::max_connections threads
+   * @return
+   */
+  static std::unique_ptr<IClient> Build(std::string_view url, HttpOptions options, std::shared_ptr<IExecutor> executor,
+                                        std::shared_ptr<IExecutor> io_executor = nullptr) noexcept;
 };
 }  // namespace reduct
 
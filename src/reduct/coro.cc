@@ -0,0 +1,161 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/coro.h"
+
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace reduct::coro {
+
+/**
+ * Buffer of records between the record callback and the consumer coroutine
+ */
+struct QueryGenerator::State {
+  const IBucket* bucket;
+  std::string entry_name;
+  std::optional<IBucket::Time> start;
+  std::optional<IBucket::Time> stop;
+  IBucket::QueryOptions options;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool started = false;
+  bool done = false;
+  bool cancelled = false;
+  Error error;
+  std::coroutine_handle<> waiting;  // consumer waiting for the next record
+  std::deque<std::pair<IBucket::ReadableRecord, size_t>> records;  // received records and sizes of their data
+  size_t buffered_size = 0;                                         // bytes of the data in records
+  std::stop_source stop_source;                                     // stops the query when the generator is gone
+  std::thread thread;                                               // thread of the query
+
+  void Start(const std::shared_ptr<State>& self) {
+    // the query waits for the consumer when the buffer is full, so it has its own thread and doesn't block
+    // the I/O threads which complete the other operations the consumer may await
+    // the query locks the mutex before it resumes the consumer, so the consumer sees the thread
+    std::lock_guard lock(mutex);
+    thread = std::thread([self] { self->Run(); });
+  }
+
+  void Run() {
+    // the callback only copies the record, so it runs on the thread which receives it
+    auto query_options = options;
+    query_options.inline_callback = true;
+    query_options.stop_token = stop_source.get_token();
+    std::stop_callback stop_by_caller(options.stop_token, [this] { stop_source.request_stop(); });
+
+    auto err = bucket->Query(entry_name, start, stop, query_options,
+                             [this](const IBucket::ReadableRecord& record) { return OnRecord(record); });
+    OnComplete(std::move(err));
+  }
+
+  bool OnRecord(const IBucket::ReadableRecord& record) {
+    auto [data, err] = options.head_only ? Result<std::string>{} : record.ReadAll();
+    const auto size = data.size();
+    auto copy = record;
+    copy.Read = [data = std::make_shared<const std::string>(std::move(data)), err](auto read_callback) {
+      if (!data->empty()) {
+        read_callback(*data);
+      }
+      return err;
+    };
+
+    std::unique_lock lock(mutex);
+    const auto max_buffer_size = options.max_buffer_size.value_or(std::numeric_limits<size_t>::max());
+    cv.wait(lock, [&] { return cancelled || records.empty() || buffered_size + size <= max_buffer_size; });
+    if (cancelled) {
+      return false;
+    }
+
+    records.emplace_back(std::move(copy), size);
+    buffered_size += size;
+    if (auto handle = std::exchange(waiting, nullptr)) {
+      // the consumer runs until it suspends again, it doesn't hold the thread after that
+      lock.unlock();
+      handle.resume();
+    }
+    return true;
+  }
+
+  void OnComplete(Error err) {
+    std::unique_lock lock(mutex);
+    done = true;
+    error = std::move(err);
+    if (auto handle = std::exchange(waiting, nullptr)) {
+      lock.unlock();
+      handle.resume();
+    }
+  }
+};
+
+bool QueryGenerator::NextRecord::await_suspend(std::coroutine_handle<> handle) {
+  // the coroutine may be resumed and destroy this awaitable before we return
+  auto state = state_;
+  std::unique_lock lock(state->mutex);
+  if (!state->records.empty() || state->done) {
+    return false;
+  }
+
+  state->waiting = handle;
+  if (!std::exchange(state->started, true)) {
+    lock.unlock();
+    state->Start(state);
+  }
+  return true;
+}
+
+std::optional<IBucket::ReadableRecord> QueryGenerator::NextRecord::await_resume() {
+  std::lock_guard lock(state_->mutex);
+  if (state_->records.empty()) {
+    return std::nullopt;
+  }
+
+  auto record = std::move(state_->records.front().first);
+  state_->buffered_size -= state_->records.front().second;
+  state_->records.pop_front();
+  state_->cv.notify_all();
+  return record;
+}
+
+QueryGenerator::QueryGenerator(const IBucket& bucket, std::string_view entry_name, std::optional<IBucket::Time> start,
+                               std::optional<IBucket::Time> stop, IBucket::QueryOptions options)
+    : state_(std::make_shared<State>()) {
+  state_->bucket = &bucket;
+  state_->entry_name = entry_name;
+  state_->start = start;
+  state_->stop = stop;
+  state_->options = std::move(options);
+}
+
+QueryGenerator::~QueryGenerator() {
+  {
+    std::lock_guard lock(state_->mutex);
+    state_->cancelled = true;
+    state_->cv.notify_all();
+  }
+
+  // wake the query if it waits for the server or for the next poll
+  state_->stop_source.request_stop();
+  if (!state_->thread.joinable()) {
+    return;
+  }
+
+  if (state_->thread.get_id() == std::this_thread::get_id()) {
+    // destroyed by the consumer resumed on the thread of the query, which stops when the consumer suspends
+    state_->thread.detach();
+  } else {
+    state_->thread.join();
+  }
+}
+
+Error QueryGenerator::error() const {
+  std::lock_guard lock(state_->mutex);
+  return state_->error;
+}
+
+}  // namespace reduct::coro
@@ -0,0 +1,189 @@
+// Copyright 2026 ReductSoftware UG
+
+#ifndef REDUCT_CPP_CORO_H
+#define REDUCT_CPP_CORO_H
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "reduct/bucket.h"
+
+namespace reduct::coro {
+
+/**
+ * @brief Awaitable result of an asynchronous operation of IBucket
+ *
+ * The operation starts when the awaitable is awaited. The coroutine is resumed in the completion callback, on the
+ * I/O thread of the bucket which ran the operation, after the bucket stopped counting it, so the coroutine may
+ * destroy the bucket. It works with any coroutine type, the library doesn't impose a task or scheduler.
+ */
+template <typename T>
+class [[nodiscard]] Awaitable {
+ public:
+  using CompletionCallback = std::function<void(T)>;
+  using Start = std::function<void(CompletionCallback)>;
+
+  explicit Awaitable(Start start) : start_(std::move(start)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    // the operation may complete and resume the coroutine before it returns, and the coroutine may destroy
+    // the awaitable, so the starter is moved to the stack
+    auto start = std::move(start_);
+    start([this, handle](T result) {
+      result_.emplace(std::move(result));
+      handle.resume();
+    });
+  }
+
+  T await_resume() { return std::move(*result_); }
+
+ private:
+  Start start_;
+  std::optional<T> result_;
+};
+
+/**
+ * @brief Write a record
+ * @param bucket bucket, it must exist until the operation is completed
+ * @param entry_name entry in bucket
+ * @param options options with timestamp, labels and content type
+ * @param callback called to provide the data
+ * @return awaitable with HTTP or communication error
+ */
+inline Awaitable<Error> Write(const IBucket& bucket, std::string_view entry_name, IBucket::WriteOptions options,
+                              IBucket::WriteRecordCallback callback) {
+  return Awaitable<Error>([&bucket, entry_name = std::string(entry_name), options = std::move(options),
+                           callback = std::move(callback)](auto on_complete) {
+    bucket.WriteAsync(entry_name, options, callback, std::move(on_complete));
+  });
+}
+
+/**
+ * @brief Write a batch of records in one HTTP request
+ * @param bucket bucket, it must exist until the operation is completed
+ * @param entry_name entry in bucket
+ * @param callback a callback to add records to batch
+ * @return awaitable with HTTP error or map of errors for each record
+ */
+inline Awaitable<Result<IBucket::BatchErrors>> WriteBatch(const IBucket& bucket, std::string_view entry_name,
+                                                          IBucket::BatchCallback callback) {
+  return Awaitable<Result<IBucket::BatchErrors>>(
+      [&bucket, entry_name = std::string(entry_name), callback = std::move(callback)](auto on_complete) {
+        bucket.WriteBatchAsync(entry_name, callback, std::move(on_complete));
+      });
+}
+
+/**
+ * @brief Read a record
+ * @param bucket bucket, it must exist until the operation is completed
+ * @param entry_name entry in bucket
+ * @param ts timestamp, if it is nullopt, the method returns the latest record
+ * @param callback called with the record. To continue receiving it should return true
+ * @return awaitable with HTTP or communication error
+ */
+inline Awaitable<Error> Read(const IBucket& bucket, std::string_view entry_name, std::optional<IBucket::Time> ts,
+                             IBucket::ReadRecordCallback callback) {
+  return Awaitable<Error>([&bucket, entry_name = std::string(entry_name), ts,
+                           callback = std::move(callback)](auto on_complete) {
+    bucket.ReadAsync(entry_name, ts, callback, std::move(on_complete));
+  });
+}
+
+/**
+ * @brief Query data for a time interval with a callback
+ * @param bucket bucket, it must exist until the operation is completed
+ * @param entry_name entry in bucket
+ * @param start start time point ,if nullopt then from very beginning
+ * @param stop stop time point, if nullopt then until the last record
+ * @param options
+ * @param callback return next record If you want to stop querying, return false
+ * @return awaitable with HTTP or communication error
+ */
+inline Awaitable<Error> Query(const IBucket& bucket, std::string_view entry_name, std::optional<IBucket::Time> start,
+                              std::optional<IBucket::Time> stop, IBucket::QueryOptions options,
+                              IBucket::ReadRecordCallback callback) {
+  return Awaitable<Error>([&bucket, entry_name = std::string(entry_name), start, stop, options = std::move(options),
+                           callback = std::move(callback)](auto on_complete) {
+    bucket.QueryAsync(entry_name, start, stop, options, callback, std::move(on_complete));
+  });
+}
+
+/**
+ * @brief Asynchronous generator of records of a query
+ *
+ * The consumer awaits Next() for each record. The records are received with their data into a buffer, so
+ * the consumer may keep them and await other operations or generators between them. The query runs on its own
+ * thread, and the coroutine is resumed on it when a record is received. If the buffered data reaches
+ * QueryOptions::max_buffer_size, the query waits for the consumer without blocking the I/O threads of the bucket.
+ *
+ * The query starts with the first Next(). The destructor stops it, also a continuous query waiting for new records,
+ * and waits for its thread, so the bucket must exist until the generator is destroyed. If the coroutine destroys
+ * the generator on the thread of the query, the query stops as soon as the coroutine suspends or returns, and
+ * the bucket must exist until then.
+ *
+ * @code
+ * QueryGenerator records(*bucket, "entry", start, stop, {});
+ * while (auto record = co_await records.Next()) {
+ *   auto [data, err] = record->ReadAll();
+ * }
+ * if (records.error()) { ... }
+ * @endcode
+ */
+class QueryGenerator {
+  struct State;
+
+ public:
+  /**
+   * Awaitable of the next record, nullopt at the end of the query or if it failed
+   */
+  class [[nodiscard]] NextRecord {
+   public:
+    explicit NextRecord(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    std::optional<IBucket::ReadableRecord> await_resume();
+
+   private:
+    std::shared_ptr<State> state_;
+  };
+
+  /**
+   * @param bucket bucket, it must exist until the generator is destroyed
+   * @param entry_name entry in bucket
+   * @param start start time point ,if nullopt then from very beginning
+   * @param stop stop time point, if nullopt then until the last record
+   * @param options query options, QueryOptions::stop_token also stops the generator
+   */
+  QueryGenerator(const IBucket& bucket, std::string_view entry_name, std::optional<IBucket::Time> start,
+                 std::optional<IBucket::Time> stop, IBucket::QueryOptions options);
+
+  ~QueryGenerator();
+
+  QueryGenerator(const QueryGenerator&) = delete;
+  QueryGenerator& operator=(const QueryGenerator&) = delete;
+
+  /**
+   * Wait for the next record
+   */
+  NextRecord Next() { return NextRecord(state_); }
+
+  /**
+   * HTTP or communication error of the query, valid when Next() returned nullopt
+   */
+  [[nodiscard]] Error error() const;
+
+ private:
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace reduct::coro
+
+#endif  // REDUCT_CPP_CORO_H
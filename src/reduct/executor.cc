@@ -0,0 +1,175 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/executor.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reduct {
+
+namespace {
+thread_local const IExecutor* current_executor = nullptr;  // executor of the worker running on this thread
+}  // namespace
+
+class Executor : public IExecutor {
+ public:
+  explicit Executor(size_t thread_count)
+      : thread_count_(std::max<size_t>(thread_count, 1)), queue_(std::make_shared<Queue>()) {}
+
+  ~Executor() override {
+    {
+      std::lock_guard lock(queue_->mutex);
+      queue_->stop = true;
+    }
+    queue_->cv.notify_all();
+
+    for (auto& worker : workers_) {
+      if (worker.get_id() == std::this_thread::get_id()) {
+        // destroyed by one of its tasks, the worker finishes the queue on its own after the task
+        worker.detach();
+      } else if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  }
+
+  void Submit(Task task) noexcept override {
+    {
+      std::lock_guard lock(queue_->mutex);
+      queue_->tasks.push_back(std::move(task));
+      // start the threads with the first task, so unused executors cost nothing
+      if (workers_.empty()) {
+        workers_.reserve(thread_count_);
+        for (size_t i = 0; i < thread_count_; ++i) {
+          workers_.emplace_back([this, queue = queue_] { Run(queue); });
+        }
+      }
+    }
+    queue_->cv.notify_one();
+  }
+
+  [[nodiscard]] size_t ThreadCount() const noexcept override { return thread_count_; }
+
+  [[nodiscard]] bool InWorkerThread() const noexcept override { return current_executor == this; }
+
+ private:
+  /**
+   * Tasks shared with the workers, so a worker may outlive the executor
+   */
+  struct Queue {
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+  };
+
+  void Run(const std::shared_ptr<Queue>& queue) {
+    current_executor = this;
+    while (true) {
+      Task task;
+      {
+        std::unique_lock lock(queue->mutex);
+        queue->cv.wait(lock, [&queue] { return queue->stop || !queue->tasks.empty(); });
+        // drain the queue before stopping so that nobody waits for a broken promise
+        if (queue->tasks.empty()) {
+          current_executor = nullptr;
+          return;
+        }
+
+        task = std::move(queue->tasks.front());
+        queue->tasks.pop_front();
+      }
+
+      // the task may destroy the executor, only the queue is used after it
+      task();
+    }
+  }
+
+  size_t thread_count_;
+  std::vector<std::thread> workers_;
+  std::shared_ptr<Queue> queue_;
+};
+
+std::shared_ptr<IExecutor> IExecutor::Build(size_t thread_count) noexcept {
+  return std::make_shared<Executor>(thread_count);
+}
+
+/**
+ * Shared with the tasks, so a task which starts after the call still finds it
+ */
+struct TaskGroup::State {
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t running = 0;
+  bool finished = false;
+};
+
+TaskGroup::TaskGroup(IExecutor* executor) : executor_(executor), state_(std::make_shared<State>()) {}
+
+TaskGroup::~TaskGroup() { Wait(); }
+
+void TaskGroup::Submit(std::function<void()> task) {
+  executor_->Submit(IExecutor::Task([state = state_, task = std::move(task)] {
+    {
+      std::lock_guard lock(state->mutex);
+      if (state->finished) {
+        return;
+      }
+      ++state->running;
+    }
+
+    task();
+
+    std::lock_guard lock(state->mutex);
+    --state->running;
+    state->cv.notify_all();
+  }));
+}
+
+void TaskGroup::Wait() noexcept {
+  std::unique_lock lock(state_->mutex);
+  state_->finished = true;
+  state_->cv.wait(lock, [this] { return state_->running == 0; });
+}
+
+Error RunParallel(size_t count, size_t max_parallel, IExecutor* executor,
+                  const std::function<Error(size_t, std::stop_token)>& task, std::stop_token stop_token) {
+  std::mutex mutex;
+  size_t next = 0;
+  Error failure;
+  std::stop_source stop_source;
+  std::stop_callback stop_by_caller(stop_token, [&stop_source] { stop_source.request_stop(); });
+
+  auto run = [&] {
+    std::unique_lock lock(mutex);
+    while (next < count && !stop_source.stop_requested()) {
+      const auto idx = next++;
+      lock.unlock();
+
+      auto err = task(idx, stop_source.get_token());
+
+      lock.lock();
+      if (err && !failure) {
+        failure = std::move(err);
+        stop_source.request_stop();
+      }
+    }
+  };
+
+  TaskGroup helpers(executor);
+  if (executor) {
+    for (size_t i = 1; i < std::min(max_parallel, count); ++i) {
+      helpers.Submit(run);
+    }
+  }
+
+  run();
+  helpers.Wait();
+  return failure;
+}
+
+}  // namespace reduct
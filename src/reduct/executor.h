@@ -0,0 +1,111 @@
+// Copyright 2026 ReductSoftware UG
+
+#ifndef REDUCT_CPP_EXECUTOR_H
+#define REDUCT_CPP_EXECUTOR_H
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <stop_token>
+
+#include "reduct/error.h"
+
+namespace reduct {
+
+/**
+ * @class IExecutor
+ * @brief Pool of threads which runs record callbacks of reads and queries or asynchronous operations.
+ *
+ * A client creates one executor of each kind and shares them with all the buckets it hands out.
+ * The threads start with the first task and sleep until a task is submitted, so idle buckets don't consume CPU.
+ * A task may destroy the executor which runs it, the remaining tasks are still run.
+ */
+class IExecutor {
+ public:
+  using Task = std::packaged_task<void()>;
+
+  virtual ~IExecutor() = default;
+
+  /**
+   * @brief Submit a task to run on one of the executor threads
+   * @param task task to run; use its future to wait for the result
+   */
+  virtual void Submit(Task task) noexcept = 0;
+
+  /**
+   * @brief Number of worker threads
+   */
+  [[nodiscard]] virtual size_t ThreadCount() const noexcept = 0;
+
+  /**
+   * @brief Check if the calling thread is a worker thread of this executor
+   *
+   * A read or query started from a record callback runs its callback on the calling thread if it is a worker,
+   * because the worker can't run a task submitted to its own executor while it waits for it.
+   */
+  [[nodiscard]] virtual bool InWorkerThread() const noexcept { return false; }
+
+  /**
+   * @brief Creates a new executor
+   * @param thread_count number of worker threads, at least one thread is always created
+   * @return a pointer to the executor
+   */
+  static std::shared_ptr<IExecutor> Build(size_t thread_count = 1) noexcept;
+};
+
+/**
+ * @class TaskGroup
+ * @brief Tasks of one call which run on an executor and use the state of the call
+ *
+ * Wait() waits only for the tasks which have started, the tasks which start after it do nothing. So a call
+ * doesn't wait for the threads of a busy executor, it must not depend on a task which hasn't started.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(IExecutor* executor);
+
+  /**
+   * @brief Waits for the started tasks
+   */
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /**
+   * @brief Submit a task to the executor, it runs only if it starts before Wait()
+   */
+  void Submit(std::function<void()> task);
+
+  /**
+   * @brief Wait for the started tasks and cancel the others
+   */
+  void Wait() noexcept;
+
+ private:
+  struct State;
+
+  IExecutor* executor_;
+  std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief Run tasks by their index, up to max_parallel at the same time on the calling thread and an executor
+ *
+ * The calling thread runs tasks too and doesn't wait for the helpers which haven't started, so it may be
+ * a thread of the executor. The first error stops the run: no new task is started and the running ones get
+ * a stop request through their stop token.
+ *
+ * @param count number of tasks
+ * @param max_parallel maximum number of tasks running at the same time
+ * @param executor runs the tasks in parallel with the calling thread, if nullptr the tasks run one by one
+ * @param task runs the task with the index, it should finish early when the stop token is stopped
+ * @param stop_token stops the run from outside like an error
+ * @return the first error, the tasks after it haven't run
+ */
+Error RunParallel(size_t count, size_t max_parallel, IExecutor* executor,
+                  const std::function<Error(size_t, std::stop_token)>& task, std::stop_token stop_token = {});
+
+}  // namespace reduct
+
+#endif  // REDUCT_CPP_EXECUTOR_H
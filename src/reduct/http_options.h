@@ -7,8 +7,34 @@
 #include <string>
 #include <optional>
 #include <chrono>
+#include <limits>
 
 namespace reduct {
+/**
+ * Limits of one batch request, bigger batches are split into several requests
+ *
+ * There are no limits by default, so a batch is written in one atomic request. A split batch may be written
+ * partially, see IBucket::WriteBatch.
+ */
+struct BatchLimits {
+  static constexpr size_t kUnlimited = std::numeric_limits<size_t>::max();
+
+  size_t max_records = kUnlimited;      // records in one request
+  size_t max_header_size = kUnlimited;  // approximate bytes of record headers in one request
+  size_t max_body_size = kUnlimited;    // bytes of body in one request, a bigger record is sent alone
+  size_t max_parallel_requests = 1;     // requests of one batch sent at the same time
+
+  auto operator<=>(const BatchLimits&) const = default;
+};
+
+/**
+ * Compression of HTTP bodies
+ */
+enum class Compression {
+  kNone,
+  kGzip,  // needs the library built with REDUCT_CPP_ENABLE_COMPRESSION, otherwise the bodies aren't compressed
+};
+
 /**
  * Client options
  */
@@ -17,6 +43,16 @@ struct HttpOptions {
   bool ssl_verification;  // check ssl certificate if it is true
   std::optional<std::chrono::milliseconds> connection_timeout;
   std::optional<std::chrono::milliseconds> request_timeout;
+  size_t max_connections = 8;  // maximum number of idle keep-alive connections kept by the client and its buckets
+  BatchLimits batch_limits;    // limits of batch requests of the client and its buckets, unlimited by default
+  Compression response_compression = Compression::kNone;  // ask the server to compress responses, they are
+                                                          // decompressed while received
+  Compression request_compression = Compression::kNone;   // compress request bodies after the server advertised
+                                                          // gzip with Accept-Encoding in a response (RFC 7694)
+  bool force_request_compression = false;  // with request_compression, compress request bodies from the first
+                                           // request without waiting for Accept-Encoding. ReductStore doesn't send
+                                           // it, so the bodies are compressed for it only with this flag, and
+                                           // the server or a proxy in front of it must decode them
 
   auto operator<=>(const HttpOptions&) const = default;
 };
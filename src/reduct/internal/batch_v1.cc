@@ -7,16 +7,14 @@
 #include <fmt/ranges.h>
 
 #include <algorithm>
+#include <charconv>
 #include <chrono>
-#include <deque>
 #include <map>
-#include <mutex>
 #include <optional>
 #include <set>
 #include <sstream>
 #include <string>
 #include <string_view>
-#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -27,8 +25,15 @@ int64_t ToMicroseconds(const IBucket::Time& ts) {
   return std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count();
 }
 
-IBucket::Time FromMicroseconds(const std::string& ts) {
-  return IBucket::Time() + std::chrono::microseconds(std::stoul(ts));
+IBucket::Time FromMicroseconds(uint64_t ts) { return IBucket::Time() + std::chrono::microseconds(ts); }
+
+std::optional<IBucket::Time> FromMicroseconds(std::string_view ts) {
+  uint64_t number = 0;
+  auto [ptr, ec] = std::from_chars(ts.data(), ts.data() + ts.size(), number);
+  if (ts.empty() || ec != std::errc() || ptr != ts.data() + ts.size()) {
+    return std::nullopt;
+  }
+  return FromMicroseconds(number);
 }
 
 std::string RecordEntry(const IBucket::Batch::Record& record, std::string_view default_entry) {
@@ -75,8 +80,77 @@ std::vector<size_t> SortRecords(const IBucket::Batch& batch, const std::string&
   return order;
 }
 
-std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV1(
-    std::deque<std::optional<std::string>>* data, std::mutex* mutex, bool head, IHttpClient::Headers&& headers) {
+std::vector<std::vector<size_t>> SplitBatch(const IBucket::Batch& batch, const std::vector<size_t>& ordered,
+                                            const std::vector<size_t>& header_sizes, bool with_body,
+                                            const BatchLimits& limits) {
+  std::vector<std::vector<size_t>> parts;
+  std::vector<size_t> part;
+  size_t header_size = 0;
+  size_t body_size = 0;
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    const auto record_size = with_body ? batch.record_data(ordered[i]).size() : 0;
+    if (!part.empty() &&
+        (part.size() >= limits.max_records || header_size + header_sizes[i] > limits.max_header_size ||
+         body_size + record_size > limits.max_body_size)) {
+      parts.push_back(std::move(part));
+      part.clear();
+      header_size = 0;
+      body_size = 0;
+    }
+
+    part.push_back(ordered[i]);
+    header_size += header_sizes[i];
+    body_size += record_size;
+  }
+
+  if (!part.empty()) {
+    parts.push_back(std::move(part));
+  }
+
+  return parts;
+}
+
+std::vector<Error> SendBatchParts(size_t part_count, size_t max_parallel, IExecutor* executor,
+                                  const std::function<Error(size_t)>& send) {
+  // each part is sent by one task, so they write their own results
+  std::vector<std::optional<Error>> results(part_count);
+  auto failure = RunParallel(part_count, max_parallel, executor, [&](size_t idx, std::stop_token) {
+    results[idx] = send(idx);
+    return *results[idx];
+  });
+
+  // the parts after a failure aren't sent
+  std::vector<Error> errors;
+  errors.reserve(part_count);
+  for (auto& result : results) {
+    errors.push_back(result ? std::move(*result) : failure);
+  }
+  return errors;
+}
+
+Error ReadBatchedRecord(ChunkQueue* data, size_t size, const IBucket::ReadableRecord::ReadCallback& callback) {
+  size_t total = 0;
+  while (total < size) {
+    auto chunk = data->Front();
+    if (!chunk) {
+      break;
+    }
+
+    // the chunk may contain the beginning of the next record, we leave it in the queue
+    const auto record_chunk = chunk->substr(0, size - total);
+    data->Consume(record_chunk.size());
+    total += record_chunk.size();
+
+    if (!callback(record_chunk)) {
+      break;
+    }
+  }
+
+  return Error::kOk;
+}
+
+std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV1(ChunkQueue* data, bool head,
+                                                                   IHttpClient::Headers&& headers) {
   auto parse_csv = [](const std::string& csv) {
     std::vector<std::string> items;
     std::string escaped, item;
@@ -122,76 +196,100 @@ std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV1(
   };
 
   std::vector<IBucket::ReadableRecord> records;
-  size_t total_records = std::count_if(headers.begin(), headers.end(), [](const auto& header) {
-    return header.first.starts_with(kHeaderTimePrefix);
-  });
-
-  std::map<std::string, std::string> ordered_headers(headers.begin(), headers.end());
-  for (auto header = ordered_headers.begin(); header != ordered_headers.end(); ++header) {
-    if (!header->first.starts_with(kHeaderTimePrefix)) {
+  // the headers are sorted, so the records are in the order of their timestamps
+  const auto record_headers = HeadersWithPrefix(headers, kHeaderTimePrefix);
+  const auto total_records = static_cast<size_t>(std::ranges::distance(record_headers));
+  const auto last_it = headers.find(kHeaderLast);
+  const bool last = last_it != headers.end() && last_it->second == "true";
+
+  records.reserve(total_records);
+  for (auto header = record_headers.begin(); header != record_headers.end(); ++header) {
+    auto timestamp = FromMicroseconds(std::string_view(header->first).substr(kHeaderTimePrefix.size()));
+    if (!timestamp) {
       continue;
     }
 
     auto [size, content_type, labels] = parse_csv(header->second);
 
     IBucket::ReadableRecord record;
-    record.timestamp = FromMicroseconds(std::string(header->first.substr(kHeaderTimePrefix.size())));
+    record.timestamp = *timestamp;
     record.size = size;
     record.content_type = content_type;
     record.labels = labels;
-    record.Read = [data, mutex, size, head](auto record_callback) {
+    record.Read = [data, size, head](auto record_callback) {
       if (head) {
         return Error::kOk;
       }
 
-      size_t total = 0;
-      while (true) {
-        std::optional<std::string> chunk = "";
-        {
-          std::lock_guard lock(*mutex);
-          if (!data->empty()) {
-            chunk = std::move(data->front());
-            data->pop_front();
-
-            if (chunk->size() > size - total) {
-              auto tmp = chunk->substr(0, size - total);
-              data->push_front(chunk->substr(size - total));
-              chunk = std::move(tmp);
-            }
-          }
-        }
+      return ReadBatchedRecord(data, size, record_callback);
+    };
 
-        if (!chunk) {
-          break;
-        }
+    record.last = (records.size() == total_records - 1 && last);
+    records.push_back(std::move(record));
+  }
 
-        if (chunk->empty()) {
-          std::this_thread::sleep_for(std::chrono::microseconds(100));
-          continue;
-        }
+  return records;
+}
 
-        total += chunk->size();
-        if (!record_callback(std::move(*chunk))) {
-          break;
-        }
+BatchBodyReader::BatchBodyReader(IBucket::Batch batch, std::vector<size_t> order)
+    : BatchBodyReader(std::make_shared<const IBucket::Batch>(std::move(batch)), std::move(order)) {}
 
-        if (total >= size) {
-          break;
-        }
+BatchBodyReader::BatchBodyReader(std::shared_ptr<const IBucket::Batch> batch, std::vector<size_t> order)
+    : batch_(std::move(batch)), order_(std::move(order)) {}
+
+std::string_view BatchBodyReader::Read(size_t offset, size_t size) {
+  if (offset != offset_) {
+    Seek(offset);
+  }
+
+  // big records go to the socket as they are, small ones are packed together to avoid tiny writes
+  buffer_.clear();
+  while (index_ < order_.size() && buffer_.size() < size) {
+    auto data = batch_->record_data(order_[index_]).substr(record_offset_);
+    if (data.empty()) {
+      ++index_;
+      record_offset_ = 0;
+      continue;
+    }
+
+    data = data.substr(0, size - buffer_.size());
+    if (data.size() >= kMinPieceSize) {
+      if (!buffer_.empty()) {
+        break;
       }
 
-      return Error::kOk;
-    };
+      record_offset_ += data.size();
+      offset_ += data.size();
+      return data;
+    }
 
-    record.last = (records.size() == total_records - 1 && headers[std::string(kHeaderLast)] == "true");
-    records.push_back(std::move(record));
+    buffer_.append(data);
+    record_offset_ += data.size();
+    offset_ += data.size();
   }
 
-  return records;
+  return buffer_;
+}
+
+void BatchBodyReader::Seek(size_t offset) {
+  index_ = 0;
+  record_offset_ = 0;
+  offset_ = 0;
+  for (; index_ < order_.size(); ++index_) {
+    const auto size = batch_->record_data(order_[index_]).size();
+    if (offset < offset_ + size) {
+      break;
+    }
+    offset_ += size;
+  }
+
+  record_offset_ = offset - offset_;
+  offset_ = offset;
 }
 
 Result<IBucket::BatchErrors> ProcessBatchV1(IHttpClient* client, std::string_view bucket_path,
-                                            std::string_view entry_name, IBucket::Batch batch, BatchType type) {
+                                            std::string_view entry_name, IBucket::Batch batch, BatchType type,
+                                            const BatchLimits& limits, IExecutor* executor) {
   auto ordered = SortRecords(batch, std::string(entry_name), false);
 
   std::set<std::string> unique_entries;
@@ -206,68 +304,99 @@ Result<IBucket::BatchErrors> ProcessBatchV1(IHttpClient* client, std::string_vie
     };
   }
 
-  IHttpClient::Headers headers;
+  std::vector<std::pair<std::string, std::string>> record_headers(batch.records().size());
+  std::vector<size_t> header_sizes;
+  header_sizes.reserve(ordered.size());
   for (auto idx : ordered) {
     const auto& record = batch.records()[idx];
-    const auto key = fmt::format("{}{}", kHeaderTimePrefix, ToMicroseconds(record.timestamp));
+    auto key = fmt::format("{}{}", kHeaderTimePrefix, ToMicroseconds(record.timestamp));
 
+    std::string value;
     switch (type) {
-      case BatchType::kWrite: {
-        const auto value = fmt::format("{},{},{}", record.size, record.content_type, FormatLabels(record.labels));
-        headers.emplace(key, value);
+      case BatchType::kWrite:
+        value = fmt::format("{},{},{}", record.size, record.content_type, FormatLabels(record.labels));
         break;
-      }
-      case BatchType::kUpdate: {
-        const auto value = fmt::format("0,,{}", FormatLabels(record.labels));
-        headers.emplace(key, value);
+      case BatchType::kUpdate:
+        value = fmt::format("0,,{}", FormatLabels(record.labels));
         break;
-      }
       case BatchType::kRemove:
-        headers.emplace(key, "0,");
+        value = "0,";
         break;
     }
+
+    header_sizes.push_back(key.size() + value.size() + 4);  // ": " and CRLF
+    record_headers[idx] = {std::move(key), std::move(value)};
   }
 
-  Result<std::tuple<std::string, IHttpClient::Headers>> resp_result;
-  switch (type) {
-    case BatchType::kWrite: {
-      const auto content_length = batch.size();
-      resp_result = client->Post(fmt::format("{}/{}/batch", bucket_path, entry_name), "application/octet-stream",
-                                content_length, std::move(headers),
-                                [ordered = std::move(ordered), batch = std::move(batch)](size_t offset, size_t size) {
-                                  return std::pair{true, batch.Slice(ordered, offset, size)};
-                                });
-      break;
+  const auto parts = SplitBatch(batch, ordered, header_sizes, type == BatchType::kWrite, limits);
+  const auto path = fmt::format("{}/{}/batch", bucket_path, entry_name);
+  const auto shared_batch = std::make_shared<const IBucket::Batch>(std::move(batch));
+
+  std::vector<IBucket::BatchErrors> part_errors(parts.size());
+  const auto part_results = SendBatchParts(parts.size(), limits.max_parallel_requests, executor, [&](size_t part_idx) {
+    const auto& part = parts[part_idx];
+    IHttpClient::Headers headers;
+    size_t content_length = 0;
+    for (auto idx : part) {
+      headers.emplace(record_headers[idx]);
+      content_length += shared_batch->record_data(idx).size();
     }
-    case BatchType::kUpdate:
-      resp_result = client->Patch(fmt::format("{}/{}/batch", bucket_path, entry_name), "", std::move(headers));
-      break;
 
-    case BatchType::kRemove:
-      resp_result = client->Delete(fmt::format("{}/{}/batch", bucket_path, entry_name), std::move(headers));
-      break;
-  }
+    Result<std::tuple<std::string, IHttpClient::Headers>> resp_result;
+    switch (type) {
+      case BatchType::kWrite:
+        resp_result = client->Post(path, "application/octet-stream", content_length, std::move(headers),
+                                   [reader = BatchBodyReader(shared_batch, part)](size_t offset, size_t size) mutable {
+                                     return std::pair{true, reader.Read(offset, size)};
+                                   });
+        break;
+      case BatchType::kUpdate:
+        resp_result = client->Patch(path, "", std::move(headers));
+        break;
+      case BatchType::kRemove:
+        resp_result = client->Delete(path, std::move(headers));
+        break;
+    }
 
-  auto [resp, err] = resp_result;
-  if (err) {
-    return {{}, err};
-  }
+    auto [resp, resp_err] = resp_result;
+    if (resp_err) {
+      return resp_err;
+    }
 
-  IBucket::BatchErrors errors;
-  for (const auto& [key, value] : std::get<1>(resp)) {
-    if (key.starts_with(kHeaderErrorPrefix)) {
+    for (const auto& [key, value] : HeadersWithPrefix(std::get<1>(resp), kHeaderErrorPrefix)) {
+      auto timestamp = FromMicroseconds(std::string_view(key).substr(kHeaderErrorPrefix.size()));
       auto pos = value.find(',');
-      if (pos == std::string::npos) {
+      if (!timestamp || pos == std::string::npos) {
         continue;
       }
       auto status = std::stoi(value.substr(0, pos));
       auto message = value.substr(pos + 1);
-      errors.emplace(FromMicroseconds(std::string(key.substr(kHeaderErrorPrefix.size()))),
-                     Error{.code = status, .message = message});
+      part_errors[part_idx].emplace(*timestamp, Error{.code = status, .message = message});
+    }
+
+    return Error::kOk;
+  });
+
+  IBucket::BatchErrors errors;
+  Error err;
+  for (size_t part_idx = 0; part_idx < parts.size(); ++part_idx) {
+    const auto& part_err = part_results[part_idx];
+    if (!part_err) {
+      errors.merge(part_errors[part_idx]);
+      continue;
+    }
+
+    // the records of a failed or unsent part aren't written
+    for (auto idx : parts[part_idx]) {
+      errors.insert_or_assign(shared_batch->records()[idx].timestamp, part_err);
+    }
+
+    if (!err) {
+      err = part_err;
     }
   }
 
-  return {errors, Error::kOk};
+  return {errors, err};
 }
 
 }  // namespace reduct::internal
@@ -3,14 +3,17 @@
 #define REDUCT_CPP_BATCH_V1_H
 
 #include <chrono>
-#include <deque>
-#include <mutex>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <string>
 #include <vector>
 
 #include "reduct/bucket.h"
+#include "reduct/executor.h"
+#include "reduct/http_options.h"
+#include "reduct/internal/chunk_queue.h"
 #include "reduct/internal/http_client.h"
 #include "reduct/result.h"
 
@@ -19,18 +22,107 @@ namespace reduct::internal {
 enum class BatchType { kWrite, kUpdate, kRemove };
 
 int64_t ToMicroseconds(const IBucket::Time& ts);
-IBucket::Time FromMicroseconds(const std::string& ts);
+IBucket::Time FromMicroseconds(uint64_t ts);
+
+/**
+ * Parse a timestamp in microseconds as a 64-bit number without exceptions
+ * @return nullopt if the string is not a number
+ */
+std::optional<IBucket::Time> FromMicroseconds(std::string_view ts);
 
 std::string RecordEntry(const IBucket::Batch::Record& record, std::string_view default_entry);
 std::string FormatLabels(const IBucket::LabelMap& labels);
 std::vector<size_t> SortRecords(const IBucket::Batch& batch, const std::string& default_entry,
                                 bool sort_by_entry);
 
-std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV1(
-    std::deque<std::optional<std::string>>* data, std::mutex* mutex, bool head, IHttpClient::Headers&& headers);
+/**
+ * Split sorted records of a batch into parts which fit the limits of one request
+ * @param batch batch with the records
+ * @param ordered indexes of the records in the order of the request
+ * @param header_sizes size of the header of each record in ordered
+ * @param with_body if true, the data of the records is sent in the body
+ * @param limits limits of one request
+ * @return indexes of the records of each part, a record which exceeds a limit alone is sent in its own part
+ */
+std::vector<std::vector<size_t>> SplitBatch(const IBucket::Batch& batch, const std::vector<size_t>& ordered,
+                                            const std::vector<size_t>& header_sizes, bool with_body,
+                                            const BatchLimits& limits);
+
+/**
+ * Send the parts of a split batch with RunParallel, up to max_parallel at the same time
+ *
+ * No new part is sent after an error, the parts sent before it stay written.
+ *
+ * @param part_count number of parts
+ * @param max_parallel maximum number of parts sent at the same time
+ * @param executor runs the parts sent in parallel with the calling thread, if nullptr the parts are sent one by one
+ * @param send sends a part by its index
+ * @return the error of each part, the parts which weren't sent get the error of the failed part
+ */
+std::vector<Error> SendBatchParts(size_t part_count, size_t max_parallel, IExecutor* executor,
+                                  const std::function<Error(size_t)>& send);
+
+std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV1(ChunkQueue* data, bool head,
+                                                                   IHttpClient::Headers&& headers);
+
+/**
+ * Read a record of a batched response from the chunk queue
+ * @param data queue with the response body
+ * @param size content length of the record
+ * @param callback called for each chunk of the record
+ */
+Error ReadBatchedRecord(ChunkQueue* data, size_t size, const IBucket::ReadableRecord::ReadCallback& callback);
+
+/**
+ * Sequential reader of a batch body in the order of the request headers.
+ *
+ * The HTTP client asks for the body chunk by chunk with growing offsets, so the reader keeps its position
+ * and sends the whole batch in one pass instead of searching the offset for each chunk.
+ */
+class BatchBodyReader {
+ public:
+  BatchBodyReader(IBucket::Batch batch, std::vector<size_t> order);
+
+  /**
+   * Reader of a part of a batch, the parts of a split batch share it
+   */
+  BatchBodyReader(std::shared_ptr<const IBucket::Batch> batch, std::vector<size_t> order);
+
+  /**
+   * Get the next piece of the body
+   *
+   * Big records are returned without copying, small ones are packed into an internal buffer
+   * so that the HTTP client doesn't write them to the socket one by one.
+   *
+   * @param offset offset in the body, may jump back or forward, then the reader seeks from the beginning
+   * @param size maximum size of the piece
+   * @return view of the data valid until the next call, empty at the end of the body
+   */
+  std::string_view Read(size_t offset, size_t size);
+
+ private:
+  // smaller pieces are copied into one buffer
+  static constexpr size_t kMinPieceSize = 16'384;
+
+  void Seek(size_t offset);
+
+  std::shared_ptr<const IBucket::Batch> batch_;
+  std::vector<size_t> order_;
+  size_t index_ = 0;          // position in order_
+  size_t record_offset_ = 0;  // offset inside the current record
+  size_t offset_ = 0;         // offset in the body
+  std::string buffer_;
+};
 
+/**
+ * Send a batch to one entry, split by the limits
+ * @param executor runs the parts sent in parallel
+ * @return errors of the records, if a part fails, its records and the records of the parts which weren't sent
+ * get its error, and the error of the first failed part is returned too
+ */
 Result<IBucket::BatchErrors> ProcessBatchV1(IHttpClient* client, std::string_view bucket_path,
-                                            std::string_view entry_name, IBucket::Batch batch, BatchType type);
+                                            std::string_view entry_name, IBucket::Batch batch, BatchType type,
+                                            const BatchLimits& limits = {}, IExecutor* executor = nullptr);
 
 }  // namespace reduct::internal
 
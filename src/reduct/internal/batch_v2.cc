@@ -7,16 +7,14 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <chrono>
-#include <deque>
 #include <limits>
-#include <mutex>
+#include <memory>
 #include <optional>
 #include <set>
-#include <sstream>
 #include <string>
 #include <string_view>
-#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
@@ -26,10 +24,15 @@
 
 namespace reduct::internal {
 
+constexpr std::string_view kDefaultContentType = "application/octet-stream";
+
+/**
+ * Parsed header of a record, the views point to the response headers
+ */
 struct RecordHeaderV2 {
   uint64_t content_length;
-  std::string content_type;
-  IBucket::LabelMap labels;
+  std::string_view content_type;
+  std::shared_ptr<const IBucket::LabelMap> labels;  // shared with the previous record if it has the same labels
 };
 
 std::string EncodeEntryName(std::string_view entry) {
@@ -47,14 +50,27 @@ std::string EncodeEntryName(std::string_view entry) {
   return encoded;
 }
 
-static std::string Trim(std::string_view value) {
+static std::string_view Trim(std::string_view value) {
   auto start = value.find_first_not_of(" \t");
   if (start == std::string_view::npos) {
-    return "";
+    return {};
   }
 
   auto end = value.find_last_not_of(" \t");
-  return std::string(value.substr(start, end - start + 1));
+  return value.substr(start, end - start + 1);
+}
+
+/**
+ * Parse a whole string as an unsigned number without exceptions
+ */
+template <typename T>
+static std::optional<T> ParseNumber(std::string_view value, int base = 10) {
+  T number = 0;
+  auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), number, base);
+  if (ec != std::errc() || ptr != value.data() + value.size() || value.empty()) {
+    return std::nullopt;
+  }
+  return number;
 }
 
 static std::optional<std::string> DecodeEntryName(std::string_view encoded) {
@@ -66,14 +82,12 @@ static std::optional<std::string> DecodeEntryName(std::string_view encoded) {
         return std::nullopt;
       }
 
-      auto hex = encoded.substr(i + 1, 2);
-      try {
-        auto value = static_cast<char>(std::stoi(std::string(hex), nullptr, 16));
-        decoded.push_back(value);
-        i += 2;
-      } catch (...) {
+      auto value = ParseNumber<uint8_t>(encoded.substr(i + 1, 2), 16);
+      if (!value) {
         return std::nullopt;
       }
+      decoded.push_back(static_cast<char>(*value));
+      i += 2;
     } else {
       decoded.push_back(encoded[i]);
     }
@@ -84,40 +98,39 @@ static std::optional<std::string> DecodeEntryName(std::string_view encoded) {
 
 static std::vector<std::string> ParseEncodedList(std::string_view raw) {
   std::vector<std::string> items;
-  std::stringstream ss{std::string(raw)};
-  std::string item;
-  while (std::getline(ss, item, ',')) {
-    item = Trim(item);
+  while (!raw.empty()) {
+    auto comma = raw.find(',');
+    auto item = Trim(raw.substr(0, comma));
     if (!item.empty()) {
       if (auto decoded = DecodeEntryName(item)) {
         items.push_back(std::move(*decoded));
       }
     }
+
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    raw.remove_prefix(comma + 1);
   }
   return items;
 }
 
-static std::optional<std::pair<size_t, uint64_t>> ParseBatchedHeaderNameV2(const std::string& name) {
-  if (!name.starts_with(kHeaderPrefix) || name.starts_with(kHeaderErrorPrefix)) {
-    return std::nullopt;
-  }
-
-  auto suffix = name.substr(kHeaderPrefix.size());
+/**
+ * Parse "<entry index>-<delta>" of a header name "x-reduct-<entry index>-<delta>"
+ */
+static std::optional<std::pair<size_t, uint64_t>> ParseBatchedHeaderNameV2(std::string_view suffix) {
   auto dash = suffix.rfind('-');
-  if (dash == std::string::npos) {
+  if (dash == std::string_view::npos) {
     return std::nullopt;
   }
 
-  auto entry_str = suffix.substr(0, dash);
-  auto delta_str = suffix.substr(dash + 1);
-
-  try {
-    auto entry_idx = static_cast<size_t>(std::stoul(entry_str));
-    auto delta = std::stoull(delta_str);
-    return std::pair{entry_idx, delta};
-  } catch (...) {
+  auto entry_idx = ParseNumber<size_t>(suffix.substr(0, dash));
+  auto delta = ParseNumber<uint64_t>(suffix.substr(dash + 1));
+  if (!entry_idx || !delta) {
     return std::nullopt;
   }
+
+  return std::pair{*entry_idx, *delta};
 }
 
 static std::vector<std::pair<std::string, std::optional<std::string>>> ParseLabelDeltaOps(
@@ -131,15 +144,10 @@ static std::vector<std::pair<std::string, std::optional<std::string>>> ParseLabe
     }
 
     auto raw_key = Trim(raw.substr(pos, eq - pos));
-    std::string key = raw_key;
+    std::string key(raw_key);
     if (label_names) {
-      bool digits = !key.empty() && std::all_of(key.begin(), key.end(),
-                                                [](char ch) { return std::isdigit(static_cast<unsigned char>(ch)); });
-      if (digits) {
-        auto idx = std::stoul(key);
-        if (idx < label_names->size()) {
-          key = label_names->at(idx);
-        }
+      if (auto idx = ParseNumber<size_t>(raw_key); idx && *idx < label_names->size()) {
+        key = label_names->at(*idx);
       }
     }
 
@@ -159,7 +167,7 @@ static std::vector<std::pair<std::string, std::optional<std::string>>> ParseLabe
       auto slice = raw.substr(pos, comma == std::string::npos ? raw.size() - pos : comma - pos);
       auto trimmed_value = Trim(slice);
       if (!trimmed_value.empty()) {
-        value = std::move(trimmed_value);
+        value = std::string(trimmed_value);
       }
       pos = comma == std::string::npos ? raw.size() : comma;
     }
@@ -189,58 +197,51 @@ static IBucket::LabelMap ApplyLabelDelta(std::string_view raw, const IBucket::La
   return labels;
 }
 
-static std::optional<RecordHeaderV2> ParseRecordHeaderV2(const std::string& raw,
-                                                         const std::optional<RecordHeaderV2>& previous,
+/**
+ * Parse a record header "<content length>[,<content type>[,<label delta>]]", the missing content type and labels
+ * are taken from the previous record of the entry
+ */
+static std::optional<RecordHeaderV2> ParseRecordHeaderV2(std::string_view raw, const RecordHeaderV2* previous,
                                                          const std::optional<std::vector<std::string>>& label_names) {
   auto first_comma = raw.find(',');
-  auto length_str =
-      Trim(first_comma == std::string::npos ? std::string_view(raw) : std::string_view(raw).substr(0, first_comma));
-  if (length_str.empty()) {
-    return std::nullopt;
-  }
-
-  uint64_t content_length = 0;
-  try {
-    content_length = std::stoull(length_str);
-  } catch (...) {
+  auto content_length = ParseNumber<uint64_t>(Trim(raw.substr(0, first_comma)));
+  if (!content_length) {
     return std::nullopt;
   }
 
-  std::string content_type;
-  std::optional<std::string> labels_raw;
-  if (first_comma != std::string::npos) {
-    auto rest = std::string_view(raw).substr(first_comma + 1);
+  std::string_view content_type;
+  std::optional<std::string_view> labels_raw;
+  if (first_comma != std::string_view::npos) {
+    auto rest = raw.substr(first_comma + 1);
     auto second_comma = rest.find(',');
-    if (second_comma == std::string::npos) {
-      content_type = Trim(rest);
-    } else {
-      content_type = Trim(rest.substr(0, second_comma));
-      labels_raw = std::string(rest.substr(second_comma + 1));
+    content_type = Trim(rest.substr(0, second_comma));
+    if (second_comma != std::string_view::npos) {
+      labels_raw = rest.substr(second_comma + 1);
     }
   }
 
   if (content_type.empty()) {
-    if (previous) {
-      content_type = previous->content_type;
-    } else {
-      content_type = "application/octet-stream";
-    }
+    content_type = previous ? previous->content_type : kDefaultContentType;
   }
 
-  auto labels = previous ? previous->labels : IBucket::LabelMap{};
+  std::shared_ptr<const IBucket::LabelMap> labels;
   if (labels_raw) {
-    labels = ApplyLabelDelta(*labels_raw, labels, label_names);
+    labels = std::make_shared<const IBucket::LabelMap>(
+        ApplyLabelDelta(*labels_raw, previous ? *previous->labels : IBucket::LabelMap{}, label_names));
+  } else if (previous) {
+    labels = previous->labels;
+  } else {
+    labels = std::make_shared<const IBucket::LabelMap>();
   }
 
-  return RecordHeaderV2{content_length, std::move(content_type), std::move(labels)};
+  return RecordHeaderV2{*content_length, content_type, std::move(labels)};
 }
 
-std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV2(std::deque<std::optional<std::string>>* data,
-                                                                   std::mutex* mutex, bool head,
-                                                                   IHttpClient::Headers&& headers) {
+std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV2(ChunkQueue* data, bool head,
+                                                                   IHttpClient::Headers&& headers, bool share_labels) {
   std::vector<IBucket::ReadableRecord> records;
-  auto entries_it = headers.find(std::string(kHeaderEntries));
-  auto start_ts_it = headers.find(std::string(kHeaderStartTs));
+  auto entries_it = headers.find(kHeaderEntries);
+  auto start_ts_it = headers.find(kHeaderStartTs);
   if (entries_it == headers.end() || start_ts_it == headers.end()) {
     return records;
   }
@@ -250,103 +251,72 @@ std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV2(std::deque<st
     return records;
   }
 
-  uint64_t start_ts = 0;
-  try {
-    start_ts = std::stoull(start_ts_it->second);
-  } catch (...) {
+  auto start_ts = ParseNumber<uint64_t>(start_ts_it->second);
+  if (!start_ts) {
     return records;
   }
 
   std::optional<std::vector<std::string>> label_names;
-  if (auto labels_it = headers.find(std::string(kHeaderLabels)); labels_it != headers.end()) {
+  if (auto labels_it = headers.find(kHeaderLabels); labels_it != headers.end()) {
     label_names = ParseEncodedList(labels_it->second);
   }
 
-  std::vector<std::tuple<size_t, uint64_t, std::string>> parsed_headers;
+  // the values are views of the headers, they are parsed in the order of entries and timestamps
+  struct RecordHeader {
+    size_t entry_idx;
+    uint64_t delta;
+    std::string_view value;
+  };
+
+  // the other x-reduct-* headers (entries, start-ts, errors...) are skipped because they are not numbers
+  std::vector<RecordHeader> parsed_headers;
   parsed_headers.reserve(headers.size());
-  for (const auto& [key, value] : headers) {
-    auto parsed = ParseBatchedHeaderNameV2(key);
-    if (!parsed) {
-      continue;
+  for (const auto& [key, value] : HeadersWithPrefix(headers, kHeaderPrefix)) {
+    auto suffix = std::string_view(key).substr(kHeaderPrefix.size());
+    if (auto parsed = ParseBatchedHeaderNameV2(suffix); parsed && parsed->first < entries.size()) {
+      parsed_headers.push_back({parsed->first, parsed->second, value});
     }
-    parsed_headers.emplace_back(parsed->first, parsed->second, value);
   }
 
   std::sort(parsed_headers.begin(), parsed_headers.end(), [](const auto& lhs, const auto& rhs) {
-    if (std::get<0>(lhs) == std::get<0>(rhs)) {
-      return std::get<1>(lhs) < std::get<1>(rhs);
-    }
-    return std::get<0>(lhs) < std::get<0>(rhs);
+    return std::tie(lhs.entry_idx, lhs.delta) < std::tie(rhs.entry_idx, rhs.delta);
   });
 
+  records.reserve(parsed_headers.size());
   std::vector<std::optional<RecordHeaderV2>> last_header(entries.size());
   for (const auto& [entry_idx, delta, value] : parsed_headers) {
-    if (entry_idx >= entries.size()) {
-      continue;
-    }
-
-    auto header = ParseRecordHeaderV2(value, last_header[entry_idx], label_names);
+    auto& previous = last_header[entry_idx];
+    auto header = ParseRecordHeaderV2(value, previous ? &*previous : nullptr, label_names);
     if (!header) {
       continue;
     }
 
-    last_header[entry_idx] = header;
+    previous = std::move(header);
 
     IBucket::ReadableRecord record;
     record.entry = entries[entry_idx];
-    record.timestamp = IBucket::Time() + std::chrono::microseconds(start_ts + delta);
-    record.size = header->content_length;
-    record.content_type = header->content_type;
-    record.labels = header->labels;
+    record.timestamp = FromMicroseconds(*start_ts + delta);
+    record.size = previous->content_length;
+    record.content_type = previous->content_type;
+    if (share_labels) {
+      record.shared_labels = previous->labels;
+    } else {
+      record.labels = *previous->labels;
+    }
     record.last = false;
-    record.Read = [data, mutex, head, size = header->content_length](auto record_callback) {
+    record.Read = [data, head, size = previous->content_length](auto record_callback) {
       if (head) {
         return Error::kOk;
       }
 
-      size_t total = 0;
-      while (true) {
-        std::optional<std::string> chunk = "";
-        {
-          std::lock_guard lock(*mutex);
-          if (!data->empty()) {
-            chunk = std::move(data->front());
-            data->pop_front();
-
-            if (chunk && chunk->size() > size - total) {
-              auto tmp = chunk->substr(0, size - total);
-              data->push_front(chunk->substr(size - total));
-              chunk = std::move(tmp);
-            }
-          }
-        }
-
-        if (!chunk) {
-          break;
-        }
-
-        if (chunk->empty()) {
-          std::this_thread::sleep_for(std::chrono::microseconds(100));
-          continue;
-        }
-
-        total += chunk->size();
-        if (!record_callback(std::move(*chunk))) {
-          break;
-        }
-
-        if (total >= size) {
-          break;
-        }
-      }
-
-      return Error::kOk;
+      return ReadBatchedRecord(data, size, record_callback);
     };
 
     records.push_back(std::move(record));
   }
 
-  if (!records.empty() && headers[std::string(kHeaderLast)] == "true") {
+  if (auto last_it = headers.find(kHeaderLast);
+      !records.empty() && last_it != headers.end() && last_it->second == "true") {
     records.back().last = true;
   }
 
@@ -382,22 +352,20 @@ struct BatchV2Request {
   IHttpClient::Headers headers;
 };
 
-Result<BatchV2Request> BuildBatchV2Request(std::string_view default_entry, const IBucket::Batch& batch, BatchType type,
-                                           bool require_entry) {
+/**
+ * Build the headers of a request with a part of a batch
+ * @param ordered indexes of the records of the part sorted by entry and timestamp
+ * @param header_values values of the record headers by record index
+ */
+BatchV2Request BuildBatchV2Request(std::string_view default_entry, const IBucket::Batch& batch,
+                                   std::vector<size_t> ordered, const std::vector<std::string>& header_values) {
   BatchV2Request request;
-  request.ordered = SortRecords(batch, std::string(default_entry), true);
-  if (request.ordered.empty()) {
-    return {request, Error::kOk};
-  }
-
+  request.ordered = std::move(ordered);
   request.start_ts = std::numeric_limits<uint64_t>::max();
   std::unordered_map<std::string, size_t> entry_indices;
   for (auto idx : request.ordered) {
     const auto& record = batch.records()[idx];
     auto entry = RecordEntry(record, default_entry);
-    if (require_entry && entry.empty()) {
-      return {BatchV2Request{}, Error{.code = 400, .message = "Entry name is required"}};
-    }
     auto ts = static_cast<uint64_t>(ToMicroseconds(record.timestamp));
     request.start_ts = std::min(request.start_ts, ts);
     if (!entry_indices.contains(entry)) {
@@ -422,24 +390,28 @@ Result<BatchV2Request> BuildBatchV2Request(std::string_view default_entry, const
     const auto delta = static_cast<uint64_t>(ToMicroseconds(record.timestamp)) - request.start_ts;
 
     auto key = fmt::format("{}{}-{}", kHeaderPrefix, entry_idx, delta);
-    request.headers.emplace(std::move(key), BuildHeaderValueV2(record, type));
+    request.headers.emplace(std::move(key), header_values[idx]);
   }
 
-  return {request, Error::kOk};
+  return request;
 }
 
 Result<std::tuple<std::string, IHttpClient::Headers>> SendBatchV2(IHttpClient* client, std::string_view io_path,
-                                                                  BatchType type, IBucket::Batch batch,
+                                                                  BatchType type,
+                                                                  std::shared_ptr<const IBucket::Batch> batch,
                                                                   std::vector<size_t> ordered,
                                                                   IHttpClient::Headers headers) {
   switch (type) {
     case BatchType::kWrite: {
-      const auto content_length = batch.size();
+      size_t content_length = 0;
+      for (auto idx : ordered) {
+        content_length += batch->record_data(idx).size();
+      }
+
       return client->Post(fmt::format("{}/write", io_path), "application/octet-stream", content_length,
                           std::move(headers),
-                          [ordered = std::move(ordered), batch = std::move(batch)](size_t offset, size_t size) {
-                            return std::pair{true, batch.Slice(ordered, offset, size)};
-                          });
+                          [reader = BatchBodyReader(std::move(batch), std::move(ordered))](
+                              size_t offset, size_t size) mutable { return std::pair{true, reader.Read(offset, size)}; });
     }
     case BatchType::kUpdate:
       return client->Patch(fmt::format("{}/update", io_path), "", std::move(headers));
@@ -450,108 +422,193 @@ Result<std::tuple<std::string, IHttpClient::Headers>> SendBatchV2(IHttpClient* c
   return {{}, Error{.code = -1, .message = "Unsupported batch type"}};
 }
 
-Result<IBucket::BatchErrors> ProcessBatchV2(IHttpClient* client, std::string_view io_path, std::string_view entry_name,
-                                            IBucket::Batch batch, BatchType type) {
-  auto [request, request_err] = BuildBatchV2Request(entry_name, batch, type, false);
-  if (request_err) {
-    return {{}, std::move(request_err)};
+/**
+ * Response to a request with a part of a batch
+ */
+struct BatchV2Response {
+  std::vector<std::string> entries;  // entries of the request
+  uint64_t start_ts = 0;             // start timestamp of the request
+  IHttpClient::Headers headers;
+
+  // error of a failed or unsent request with the entries and timestamps of its records, which aren't written
+  Error error;
+  std::vector<std::pair<std::string, IBucket::Time>> records;
+};
+
+/**
+ * Split a batch into requests by the limits and send them
+ * @param require_entry if true, every record must have an entry name
+ * @return responses in the order of the parts, including the failed and unsent ones
+ */
+Result<std::vector<BatchV2Response>> SendSplitBatchV2(IHttpClient* client, std::string_view io_path,
+                                                      std::string_view default_entry, IBucket::Batch batch,
+                                                      BatchType type, bool require_entry, const BatchLimits& limits,
+                                                      IExecutor* executor) {
+  auto ordered = SortRecords(batch, std::string(default_entry), true);
+
+  uint64_t start_ts = std::numeric_limits<uint64_t>::max();
+  for (auto idx : ordered) {
+    start_ts = std::min(start_ts, static_cast<uint64_t>(ToMicroseconds(batch.records()[idx].timestamp)));
+  }
+
+  // the key of a record in a part has a smaller entry index and delta than in the whole batch,
+  // so the sizes are an upper bound
+  std::vector<std::string> header_values(batch.records().size());
+  std::vector<size_t> header_sizes;
+  header_sizes.reserve(ordered.size());
+  std::optional<std::string> last_entry;
+  size_t entry_idx = 0;
+  for (auto idx : ordered) {
+    const auto& record = batch.records()[idx];
+    auto entry = RecordEntry(record, default_entry);
+    if (require_entry && entry.empty()) {
+      return {{}, Error{.code = 400, .message = "Entry name is required"}};
+    }
+
+    if (last_entry && entry != *last_entry) {
+      ++entry_idx;
+    }
+    last_entry = std::move(entry);
+
+    header_values[idx] = BuildHeaderValueV2(record, type);
+    const auto delta = static_cast<uint64_t>(ToMicroseconds(record.timestamp)) - start_ts;
+    const auto key_size = kHeaderPrefix.size() + std::to_string(entry_idx).size() + 1 + std::to_string(delta).size();
+    header_sizes.push_back(key_size + header_values[idx].size() + 4);  // ": " and CRLF
   }
-  if (request.ordered.empty()) {
-    return {IBucket::BatchErrors{}, Error::kOk};
+
+  const auto parts = SplitBatch(batch, ordered, header_sizes, type == BatchType::kWrite, limits);
+  const auto shared_batch = std::make_shared<const IBucket::Batch>(std::move(batch));
+
+  std::vector<BatchV2Response> responses(parts.size());
+  const auto errors = SendBatchParts(parts.size(), limits.max_parallel_requests, executor, [&](size_t part_idx) {
+    auto request = BuildBatchV2Request(default_entry, *shared_batch, parts[part_idx], header_values);
+    auto [resp, resp_err] =
+        SendBatchV2(client, io_path, type, shared_batch, std::move(request.ordered), std::move(request.headers));
+    if (resp_err) {
+      return resp_err;
+    }
+
+    responses[part_idx] = {std::move(request.entries), request.start_ts, std::move(std::get<1>(resp))};
+    return Error::kOk;
+  });
+
+  for (size_t part_idx = 0; part_idx < parts.size(); ++part_idx) {
+    if (!errors[part_idx]) {
+      continue;
+    }
+
+    auto& response = responses[part_idx];
+    response.error = errors[part_idx];
+    for (auto idx : parts[part_idx]) {
+      const auto& record = shared_batch->records()[idx];
+      response.records.emplace_back(RecordEntry(record, default_entry), record.timestamp);
+    }
   }
 
-  auto [resp, err] =
-      SendBatchV2(client, io_path, type, std::move(batch), std::move(request.ordered), std::move(request.headers));
+  return {std::move(responses), Error::kOk};
+}
+
+Result<IBucket::BatchErrors> ProcessBatchV2(IHttpClient* client, std::string_view io_path, std::string_view entry_name,
+                                            IBucket::Batch batch, BatchType type, const BatchLimits& limits,
+                                            IExecutor* executor) {
+  auto [responses, err] =
+      SendSplitBatchV2(client, io_path, entry_name, std::move(batch), type, false, limits, executor);
   if (err) {
     return {{}, err};
   }
 
   IBucket::BatchErrors errors;
-  for (const auto& [key, value] : std::get<1>(resp)) {
-    if (key.starts_with(kHeaderErrorPrefix)) {
-      auto prefix = key.substr(kHeaderErrorPrefix.size());
+  for (const auto& response : responses) {
+    if (response.error) {
+      for (const auto& [entry, timestamp] : response.records) {
+        errors.insert_or_assign(timestamp, response.error);
+      }
+      if (!err) {
+        err = response.error;
+      }
+      continue;
+    }
+
+    for (const auto& [key, value] : HeadersWithPrefix(response.headers, kHeaderErrorPrefix)) {
+      auto prefix = std::string_view(key).substr(kHeaderErrorPrefix.size());
       auto dash = prefix.rfind('-');
       if (dash == std::string::npos) {
         continue;
       }
-      auto delta = std::stoull(prefix.substr(dash + 1));
+      auto delta = ParseNumber<uint64_t>(prefix.substr(dash + 1));
       auto pos = value.find(',');
-      if (pos == std::string::npos) {
+      if (!delta || pos == std::string::npos) {
         continue;
       }
       auto status = std::stoi(value.substr(0, pos));
       auto message = value.substr(pos + 1);
-      errors.emplace(FromMicroseconds(std::to_string(request.start_ts + delta)),
-                     Error{.code = status, .message = message});
+      errors.emplace(FromMicroseconds(response.start_ts + *delta), Error{.code = status, .message = message});
     }
   }
 
-  return {errors, Error::kOk};
+  return {errors, err};
 }
 
 Result<IBucket::BatchRecordErrors> ProcessBatchV2Records(IHttpClient* client, std::string_view io_path,
-                                                         IBucket::Batch batch, BatchType type) {
-  auto [request, request_err] = BuildBatchV2Request("", batch, type, true);
-  if (request_err) {
-    return {{}, std::move(request_err)};
-  }
-  if (request.ordered.empty()) {
-    return {IBucket::BatchRecordErrors{}, Error::kOk};
-  }
-
-  auto [resp, err] =
-      SendBatchV2(client, io_path, type, std::move(batch), std::move(request.ordered), std::move(request.headers));
+                                                         IBucket::Batch batch, BatchType type,
+                                                         const BatchLimits& limits, IExecutor* executor) {
+  auto [responses, err] = SendSplitBatchV2(client, io_path, "", std::move(batch), type, true, limits, executor);
   if (err) {
     return {{}, err};
   }
 
-  const auto& resp_headers = std::get<1>(resp);
-  auto entries_it = resp_headers.find(std::string(kHeaderEntries));
-  auto start_ts_it = resp_headers.find(std::string(kHeaderStartTs));
+  IBucket::BatchRecordErrors errors;
+  for (const auto& response : responses) {
+    if (response.error) {
+      for (const auto& [entry, timestamp] : response.records) {
+        errors[entry].insert_or_assign(timestamp, response.error);
+      }
+      if (!err) {
+        err = response.error;
+      }
+      continue;
+    }
 
-  std::vector<std::string> entries;
-  if (entries_it != resp_headers.end()) {
-    entries = ParseEncodedList(entries_it->second);
-  }
-  if (entries.empty()) {
-    entries = request.entries;
-  }
+    const auto& resp_headers = response.headers;
+    auto entries_it = resp_headers.find(kHeaderEntries);
+    auto start_ts_it = resp_headers.find(kHeaderStartTs);
 
-  uint64_t start_ts = request.start_ts;
-  if (start_ts_it != resp_headers.end()) {
-    try {
-      start_ts = std::stoull(start_ts_it->second);
-    } catch (...) {
-      start_ts = request.start_ts;
+    std::vector<std::string> entries;
+    if (entries_it != resp_headers.end()) {
+      entries = ParseEncodedList(entries_it->second);
+    }
+    if (entries.empty()) {
+      entries = response.entries;
     }
-  }
 
-  IBucket::BatchRecordErrors errors;
-  for (const auto& [key, value] : std::get<1>(resp)) {
-    if (key.starts_with(kHeaderErrorPrefix)) {
-      auto prefix = key.substr(kHeaderErrorPrefix.size());
+    uint64_t start_ts = response.start_ts;
+    if (start_ts_it != resp_headers.end()) {
+      start_ts = ParseNumber<uint64_t>(start_ts_it->second).value_or(response.start_ts);
+    }
+
+    for (const auto& [key, value] : HeadersWithPrefix(resp_headers, kHeaderErrorPrefix)) {
+      auto prefix = std::string_view(key).substr(kHeaderErrorPrefix.size());
       auto dash = prefix.rfind('-');
       if (dash == std::string::npos) {
         continue;
       }
-      auto entry_idx = std::stoul(prefix.substr(0, dash));
-      if (entry_idx >= entries.size()) {
+      auto entry_idx = ParseNumber<size_t>(prefix.substr(0, dash));
+      auto delta = ParseNumber<uint64_t>(prefix.substr(dash + 1));
+      if (!entry_idx || *entry_idx >= entries.size() || !delta) {
         continue;
       }
-      auto delta = std::stoull(prefix.substr(dash + 1));
       auto pos = value.find(',');
       if (pos == std::string::npos) {
         continue;
       }
       auto status = std::stoi(value.substr(0, pos));
       auto message = value.substr(pos + 1);
-      const auto& entry = entries[entry_idx];
-      errors[entry].emplace(FromMicroseconds(std::to_string(start_ts + delta)),
-                            Error{.code = status, .message = message});
+      const auto& entry = entries[*entry_idx];
+      errors[entry].emplace(FromMicroseconds(start_ts + *delta), Error{.code = status, .message = message});
     }
   }
 
-  return {errors, Error::kOk};
+  return {errors, err};
 }
 
 }  // namespace reduct::internal
@@ -2,8 +2,6 @@
 #ifndef REDUCT_CPP_BATCH_V2_H
 #define REDUCT_CPP_BATCH_V2_H
 
-#include <deque>
-#include <mutex>
 #include <optional>
 #include <string_view>
 #include <vector>
@@ -12,13 +10,30 @@
 
 namespace reduct::internal {
 
-std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV2(
-    std::deque<std::optional<std::string>>* data, std::mutex* mutex, bool head, IHttpClient::Headers&& headers);
+/**
+ * Parse the headers of a batched response and build its records
+ * @param data queue with the response body
+ * @param head if true, the records have no data
+ * @param headers response headers
+ * @param share_labels if true, the records get ReadableRecord::shared_labels instead of a copy of the labels
+ */
+std::vector<IBucket::ReadableRecord> ParseAndBuildBatchedRecordsV2(ChunkQueue* data, bool head,
+                                                                   IHttpClient::Headers&& headers,
+                                                                   bool share_labels = false);
 
+/**
+ * Send a batch, split by the limits
+ * @param executor runs the parts sent in parallel
+ * @return errors of the records, if a part fails, its records and the records of the parts which weren't sent
+ * get its error, and the error of the first failed part is returned too
+ */
 Result<IBucket::BatchErrors> ProcessBatchV2(IHttpClient* client, std::string_view io_path,
-                                            std::string_view entry_name, IBucket::Batch batch, BatchType type);
+                                            std::string_view entry_name, IBucket::Batch batch, BatchType type,
+                                            const BatchLimits& limits = {}, IExecutor* executor = nullptr);
 Result<IBucket::BatchRecordErrors> ProcessBatchV2Records(IHttpClient* client, std::string_view io_path,
-                                                         IBucket::Batch batch, BatchType type);
+                                                         IBucket::Batch batch, BatchType type,
+                                                         const BatchLimits& limits = {},
+                                                         IExecutor* executor = nullptr);
 
 }  // namespace reduct::internal
 
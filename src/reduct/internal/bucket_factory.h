@@ -0,0 +1,29 @@
+// Copyright 2026 ReductSoftware UG
+#ifndef REDUCT_CPP_BUCKET_FACTORY_H
+#define REDUCT_CPP_BUCKET_FACTORY_H
+
+#include <memory>
+#include <string_view>
+
+#include "reduct/bucket.h"
+#include "reduct/executor.h"
+#include "reduct/internal/http_client.h"
+
+namespace reduct::internal {
+
+/**
+ * Create a bucket which sends its requests through the given HTTP client,
+ * so a client and its buckets share one pool of connections
+ * @param name name of the bucket
+ * @param client HTTP client of the owner
+ * @param executor executor for record callbacks
+ * @param io_executor executor for asynchronous operations
+ * @param batch_limits limits of batch requests
+ */
+std::unique_ptr<IBucket> BuildBucket(std::string_view name, std::shared_ptr<IHttpClient> client,
+                                     std::shared_ptr<IExecutor> executor, std::shared_ptr<IExecutor> io_executor,
+                                     BatchLimits batch_limits) noexcept;
+
+}  // namespace reduct::internal
+
+#endif  // REDUCT_CPP_BUCKET_FACTORY_H
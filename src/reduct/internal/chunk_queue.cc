@@ -0,0 +1,90 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/internal/chunk_queue.h"
+
+#include <algorithm>
+
+namespace reduct::internal {
+
+ChunkQueue::ChunkQueue(size_t capacity, size_t max_bytes)
+    : slots_(std::max<size_t>(capacity, 1)), max_bytes_(max_bytes) {}
+
+bool ChunkQueue::Push(std::string_view chunk) {
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  std::optional<std::chrono::steady_clock::time_point> blocked_since;
+  while (true) {
+    const auto head = head_.load(std::memory_order_acquire);
+    if (head & kFlag) {
+      return false;
+    }
+
+    // a chunk bigger than the limit is accepted when the ring is empty, otherwise we would wait forever
+    const auto buffered = buffered_bytes_.load(std::memory_order_acquire);
+    if (tail - head < slots_.size() && (buffered == 0 || buffered + chunk.size() <= max_bytes_)) {
+      break;
+    }
+
+    if (!blocked_since) {
+      blocked_since = std::chrono::steady_clock::now();
+    }
+
+    // the consumer moves the head after each taken chunk and the buffered size goes down with it
+    head_.wait(head, std::memory_order_acquire);
+  }
+
+  if (blocked_since) {
+    blocked_time_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                             *blocked_since);
+  }
+
+  slots_[tail % slots_.size()].assign(chunk);
+  buffered_bytes_.fetch_add(chunk.size(), std::memory_order_release);
+  tail_.store(tail + 1, std::memory_order_release);
+  tail_.notify_one();
+  return true;
+}
+
+void ChunkQueue::Close() {
+  tail_.fetch_or(kFlag, std::memory_order_release);
+  tail_.notify_one();
+}
+
+std::optional<std::string_view> ChunkQueue::Front() {
+  if (head_.load(std::memory_order_relaxed) & kFlag) {
+    return std::nullopt;
+  }
+
+  while (offset_ >= current_.size()) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    while (true) {
+      const auto tail = tail_.load(std::memory_order_acquire);
+      if ((tail & ~kFlag) != head) {
+        break;
+      }
+
+      if (tail & kFlag) {
+        return std::nullopt;
+      }
+
+      tail_.wait(tail, std::memory_order_acquire);
+    }
+
+    // swap the buffers, so the slot gets back the memory of the previous chunk
+    current_.swap(slots_[head % slots_.size()]);
+    offset_ = 0;
+    buffered_bytes_.fetch_sub(current_.size(), std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+    head_.notify_one();
+  }
+
+  return std::string_view(current_).substr(offset_);
+}
+
+void ChunkQueue::Consume(size_t size) { offset_ = std::min(offset_ + size, current_.size()); }
+
+void ChunkQueue::Cancel() {
+  head_.fetch_or(kFlag, std::memory_order_release);
+  head_.notify_one();
+}
+
+}  // namespace reduct::internal
@@ -0,0 +1,90 @@
+// Copyright 2026 ReductSoftware UG
+#ifndef REDUCT_CPP_CHUNK_QUEUE_H
+#define REDUCT_CPP_CHUNK_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reduct::internal {
+
+/**
+ * Bounded single-producer/single-consumer ring of data chunks of an HTTP response.
+ *
+ * The HTTP thread pushes chunks, the thread running record callbacks pops them.
+ * Both sides block on the ring positions (futex on Linux) instead of polling.
+ * The slots keep their buffers, so after warming up the ring doesn't allocate memory.
+ * The producer also blocks when the buffered data exceeds the byte limit, which slows down
+ * the HTTP transfer to the speed of the consumer.
+ */
+class ChunkQueue {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024;
+
+  explicit ChunkQueue(size_t capacity = kDefaultCapacity, size_t max_bytes = std::numeric_limits<size_t>::max());
+
+  ChunkQueue(const ChunkQueue&) = delete;
+  ChunkQueue& operator=(const ChunkQueue&) = delete;
+
+  /**
+   * Copy a chunk into the ring, blocks while the ring is full (producer only)
+   * @return false if the consumer cancelled reading and the chunk was dropped
+   */
+  bool Push(std::string_view chunk);
+
+  /**
+   * Mark the end of the stream (producer only)
+   */
+  void Close();
+
+  /**
+   * Total time the producer waited for free space (producer only)
+   */
+  [[nodiscard]] std::chrono::microseconds BlockedTime() const { return blocked_time_; }
+
+  /**
+   * Get the unread part of the current chunk, blocks while the ring is empty (consumer only)
+   *
+   * A chunk may contain data of several records, so the consumer takes only its bytes with Consume
+   * and the next record gets the rest without copying.
+   *
+   * @return view of the data valid until the next call of Front, or nullopt at the end of the stream
+   */
+  std::optional<std::string_view> Front();
+
+  /**
+   * Mark bytes of the current chunk as read (consumer only)
+   * @param size number of bytes, no more than the size of the view returned by Front
+   */
+  void Consume(size_t size);
+
+  /**
+   * Stop reading, the producer drops all the following chunks and doesn't block anymore (consumer only)
+   */
+  void Cancel();
+
+ private:
+  // the highest bit of a position marks the closed (tail) or cancelled (head) state
+  static constexpr size_t kFlag = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+  std::vector<std::string> slots_;
+  size_t max_bytes_;
+  alignas(64) std::atomic<size_t> head_ = 0;
+  alignas(64) std::atomic<size_t> tail_ = 0;
+  std::atomic<size_t> buffered_bytes_ = 0;
+
+  // producer state
+  std::chrono::microseconds blocked_time_{0};
+
+  // consumer state
+  std::string current_;
+  size_t offset_ = 0;
+};
+
+}  // namespace reduct::internal
+
+#endif  // REDUCT_CPP_CHUNK_QUEUE_H
@@ -0,0 +1,187 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/internal/codec.h"
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+namespace reduct {
+
+namespace internal {
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+namespace {
+
+constexpr int kGzipWindowBits = 15 + 16;  // max window with a gzip header and trailer
+constexpr size_t kInflateBufferSize = 64 * 1024;
+
+/**
+ * Streaming gzip decoder, it inflates the chunks of a record as they are received
+ */
+class Inflater {
+ public:
+  Inflater() { initialized_ = inflateInit2(&stream_, kGzipWindowBits) == Z_OK; }
+
+  Inflater(const Inflater&) = delete;
+  Inflater& operator=(const Inflater&) = delete;
+
+  ~Inflater() {
+    if (initialized_) {
+      inflateEnd(&stream_);
+    }
+  }
+
+  /**
+   * Inflate a chunk and pass the decompressed data to the callback
+   * @param stopped set to true if the callback returns false
+   */
+  Error Push(std::string_view chunk, const IBucket::ReadableRecord::ReadCallback& callback, bool* stopped) {
+    if (!initialized_) {
+      return Error{.code = -1, .message = "Failed to initialize gzip decoder"};
+    }
+
+    while (!chunk.empty() && !finished_) {
+      // zlib takes uInt sizes
+      const auto input_size = std::min<size_t>(chunk.size(), std::numeric_limits<uInt>::max());
+      stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+      stream_.avail_in = static_cast<uInt>(input_size);
+
+      // the output buffer isn't filled up only when the input is consumed or the stream is over
+      do {
+        stream_.next_out = reinterpret_cast<Bytef*>(buffer_.data());
+        stream_.avail_out = static_cast<uInt>(buffer_.size());
+
+        const auto ret = inflate(&stream_, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+          return Error{.code = -1, .message = "Failed to decompress record: invalid gzip data"};
+        }
+
+        const auto size = buffer_.size() - stream_.avail_out;
+        if (size > 0 && !callback(std::string_view(buffer_.data(), size))) {
+          *stopped = true;
+          return Error::kOk;
+        }
+
+        finished_ = ret == Z_STREAM_END;
+      } while (stream_.avail_out == 0 && !finished_);
+
+      chunk.remove_prefix(input_size - stream_.avail_in);
+    }
+
+    return Error::kOk;
+  }
+
+  [[nodiscard]] bool finished() const { return finished_; }
+
+ private:
+  z_stream stream_{};
+  bool initialized_ = false;
+  bool finished_ = false;
+  std::array<char, kInflateBufferSize> buffer_{};
+};
+
+}  // namespace
+
+std::optional<std::string> CompressRecord(std::string_view data, Compression compression) {
+  if (compression != Compression::kGzip || data.empty() || data.size() > std::numeric_limits<uInt>::max()) {
+    return std::nullopt;
+  }
+
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kGzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return std::nullopt;
+  }
+
+  std::string compressed(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+  stream.avail_out = static_cast<uInt>(compressed.size());
+
+  const auto ret = deflate(&stream, Z_FINISH);
+  const auto size = stream.total_out;
+  deflateEnd(&stream);
+
+  if (ret != Z_STREAM_END || size >= data.size()) {
+    return std::nullopt;
+  }
+
+  compressed.resize(size);
+  return compressed;
+}
+
+static IBucket::ReadableRecord DecodeGzip(const IBucket::ReadableRecord& record) {
+  auto decoded = record;
+  decoded.Read = [read = record.Read](const IBucket::ReadableRecord::ReadCallback& callback) {
+    Inflater inflater;
+    Error inflate_err;
+    bool stopped = false;
+    auto err = read([&](std::string_view chunk) {
+      inflate_err = inflater.Push(chunk, callback, &stopped);
+      return !inflate_err && !stopped;
+    });
+
+    if (inflate_err) {
+      return inflate_err;
+    }
+
+    if (err) {
+      return err;
+    }
+
+    if (!stopped && !inflater.finished()) {
+      return Error{.code = -1, .message = "Failed to decompress record: gzip data is truncated"};
+    }
+
+    return Error::kOk;
+  };
+  return decoded;
+}
+#else
+std::optional<std::string> CompressRecord(std::string_view /*data*/, Compression /*compression*/) {
+  return std::nullopt;
+}
+
+static IBucket::ReadableRecord DecodeGzip(const IBucket::ReadableRecord& record) {
+  auto decoded = record;
+  decoded.Read = [](const IBucket::ReadableRecord::ReadCallback&) {
+    return Error{.code = -1, .message = "Record is compressed with gzip, but the library is built without zlib"};
+  };
+  return decoded;
+}
+#endif
+
+IBucket::ReadRecordCallback DecodeRecords(IBucket::ReadRecordCallback callback) {
+  return [callback = std::move(callback)](const IBucket::ReadableRecord& record) {
+    static const std::string kLabel(kEncodingLabel);
+    const auto& labels = record.shared_labels ? *record.shared_labels : record.labels;
+    auto encoding = labels.find(kLabel);
+    if (encoding == labels.end() || encoding->second != kGzipEncoding) {
+      return callback(record);
+    }
+
+    return callback(DecodeGzip(record));
+  };
+}
+
+}  // namespace internal
+
+void IBucket::Batch::AddRecord(std::string entry, Time timestamp, std::string_view data, Compression compression,
+                               std::string content_type, LabelMap labels) {
+  auto compressed = internal::CompressRecord(data, compression);
+  if (!compressed) {
+    AddRecord(std::move(entry), timestamp, data, std::move(content_type), std::move(labels));
+    return;
+  }
+
+  labels[std::string(internal::kEncodingLabel)] = internal::kGzipEncoding;
+  AddRecord(std::move(entry), timestamp, std::move(*compressed), std::move(content_type), std::move(labels));
+}
+
+}  // namespace reduct
@@ -0,0 +1,34 @@
+// Copyright 2026 ReductSoftware UG
+#ifndef REDUCT_CPP_CODEC_H
+#define REDUCT_CPP_CODEC_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "reduct/bucket.h"
+#include "reduct/http_options.h"
+
+namespace reduct::internal {
+
+/**
+ * Label which tags a record compressed by the client, its value is the codec
+ */
+constexpr std::string_view kEncodingLabel = "content-encoding";
+constexpr std::string_view kGzipEncoding = "gzip";
+
+/**
+ * Compress the payload of a record
+ * @return compressed data or nullopt if the data should be stored as is: no compression, the library is built
+ * without zlib, or the compressed data is not smaller
+ */
+std::optional<std::string> CompressRecord(std::string_view data, Compression compression);
+
+/**
+ * Wrap a record callback, so the records tagged with kEncodingLabel are decompressed while they are read
+ */
+IBucket::ReadRecordCallback DecodeRecords(IBucket::ReadRecordCallback callback);
+
+}  // namespace reduct::internal
+
+#endif  // REDUCT_CPP_CODEC_H
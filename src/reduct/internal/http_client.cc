@@ -9,9 +9,11 @@
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace reduct::internal {
 
@@ -19,50 +21,41 @@ using httplib::DataSink;
 
 constexpr size_t kMaxChunkSize = 512'000;
 
-Result<IHttpClient::Headers> NormalizeHeaders(httplib::Result res) {
+/**
+ * Move the response headers without copying the names and values, the names are compared case-insensitively
+ */
+IHttpClient::Headers NormalizeHeaders(httplib::Headers* headers) {
   IHttpClient::Headers response_headers;
-  for (auto& [k, v] : res->headers) {
-    std::string lowcase_header = k;
-    std::transform(k.begin(), k.end(), lowcase_header.begin(), [](auto ch) { return tolower(ch); });
-    response_headers[lowcase_header] = v;
-  }
+  response_headers.merge(*headers);
+  return response_headers;
+}
 
-  return {std::move(response_headers), Error::kOk};
+/**
+ * Move the request headers to the httplib headers without copying
+ */
+httplib::Headers ToHttplibHeaders(IHttpClient::Headers* headers) {
+  httplib::Headers httplib_headers;
+  httplib_headers.merge(*headers);
+  return httplib_headers;
 }
 
 class HttpClient : public IHttpClient {
  public:
-  explicit HttpClient(const std::string_view url, const HttpOptions& options) : api_token_(options.api_token) {
-    std::string_view base_url;
+  explicit HttpClient(const std::string_view url, const HttpOptions& options)
+      : options_(options),
+        api_token_(options.api_token),
+        server_accepts_gzip_(options.request_compression == Compression::kGzip &&
+                             options.force_request_compression) {
     std::string_view path_prefix;
     auto path_start = url.find('/', url.find("://") + 3);
     if (path_start != std::string_view::npos) {
-      base_url = url.substr(0, path_start);
+      base_url_ = url.substr(0, path_start);
       path_prefix = url.substr(path_start);
     } else {
-      base_url = url;
+      base_url_ = url;
       path_prefix = "";
     }
 
-    client_ = std::make_unique<httplib::Client>(std::string(base_url));
-    client_->enable_server_certificate_verification(options.ssl_verification);
-
-    if (!options.api_token.empty()) {
-      client_->set_bearer_token_auth(options.api_token);
-    }
-
-    if (options.connection_timeout.has_value()) {
-      client_->set_connection_timeout(
-          std::chrono::duration_cast<std::chrono::seconds>(options.connection_timeout.value()).count());
-    }
-
-    if (options.request_timeout.has_value()) {
-      client_->set_read_timeout(
-          std::chrono::duration_cast<std::chrono::seconds>(options.request_timeout.value()).count());
-      client_->set_write_timeout(
-          std::chrono::duration_cast<std::chrono::seconds>(options.request_timeout.value()).count());
-    }
-
     if (path_prefix.ends_with("/")) {
       api_prefix_ = fmt::format("{}{}", path_prefix.substr(0, path_prefix.size() - 1), kApiPrefix);
     } else {
@@ -71,7 +64,7 @@ class HttpClient : public IHttpClient {
   }
 
   Result<std::string> Get(std::string_view path) const noexcept override {
-    auto res = client_->Get(AddApiPrefix(path));
+    auto res = Acquire()->Get(AddApiPrefix(path));
     if (auto err = CheckRequest(res)) {
       return {{}, std::move(err)};
     }
@@ -85,29 +78,21 @@ class HttpClient : public IHttpClient {
 
   Error Get(std::string_view path, Headers headers, ResponseCallback resp_callback,
             ReadCallback read_callback) const noexcept override {
-    httplib::Headers httplib_headers;
-    for (auto& [k, v] : headers) {
-      httplib_headers.emplace(k, v);
-    }
+    auto httplib_headers = ToHttplibHeaders(&headers);
 
     Error err = Error::kOk;
     std::string err_body;
-    auto res = client_->Get(
+    auto res = Acquire()->Get(
         AddApiPrefix(path), httplib_headers,
         [&](const auto& response) {
+          DetectRequestCompression(response.headers);
           if (response.status != 200) {
             err.code = response.status;
           }
 
-          Headers normalized_headers;
-          for (auto& [k, v] : response.headers) {
-            std::string lowcase_header = k;
-            std::transform(k.begin(), k.end(), lowcase_header.begin(), [](auto ch) { return std::tolower(ch); });
-            normalized_headers[lowcase_header] = v;
-          }
-
           if (!err) {
-            resp_callback(std::move(normalized_headers));
+            // the response is const in the callback, the headers are copied but not transformed
+            resp_callback(Headers(response.headers.begin(), response.headers.end()));
           }
           return true;
         },
@@ -125,25 +110,15 @@ class HttpClient : public IHttpClient {
   Result<Headers> Head(std::string_view path) const noexcept override { return Head(path, {}); }
 
   Result<Headers> Head(std::string_view path, Headers headers) const noexcept override {
-    httplib::Headers httplib_headers;
-    for (auto& [k, v] : headers) {
-      httplib_headers.emplace(k, v);
-    }
+    auto httplib_headers = ToHttplibHeaders(&headers);
 
-    auto res = client_->Head(AddApiPrefix(path).data(), httplib_headers);
+    auto res = Acquire()->Head(AddApiPrefix(path).data(), httplib_headers);
     auto err = CheckRequest(res);
     if (err) {
       return {{}, std::move(err)};
     }
 
-    Headers normalized_headers;
-    for (auto& [k, v] : res->headers) {
-      std::string lowcase_header = k;
-      std::transform(k.begin(), k.end(), lowcase_header.begin(), [](auto ch) { return std::tolower(ch); });
-      normalized_headers[lowcase_header] = v;
-    }
-
-    return {std::move(normalized_headers), Error::kOk};
+    return {NormalizeHeaders(&res->headers), Error::kOk};
   }
 
   Error Post(std::string_view path, std::string_view body, std::string_view mime) const noexcept override {
@@ -153,7 +128,7 @@ class HttpClient : public IHttpClient {
 
   Result<std::string> PostWithResponse(std::string_view path, std::string_view body,
                                        std::string_view mime) const noexcept override {
-    auto res = client_->Post(AddApiPrefix(path).data(), body.data(), mime.data());
+    auto res = Acquire()->Post(AddApiPrefix(path).data(), body.data(), mime.data());
     if (auto err = CheckRequest(res)) {
       return {{}, std::move(err)};
     }
@@ -163,16 +138,18 @@ class HttpClient : public IHttpClient {
 
   Result<std::tuple<std::string, Headers>> Post(std::string_view path, std::string_view mime, size_t content_length,
                                                 Headers headers, WriteCallback callback) const noexcept override {
-    httplib::Headers httplib_headers;
-    for (auto& [k, v] : headers) {
-      httplib_headers.emplace(k, v);
-    }
-    auto res = client_->Post(
+    auto httplib_headers = ToHttplibHeaders(&headers);
+    auto res = Acquire()->Post(
         AddApiPrefix(path), httplib_headers, content_length,
         [&](size_t offset, size_t size, DataSink& sink) {
           size = std::min<size_t>(size, kMaxChunkSize);
           auto [ok, data] = callback(offset, size);
-          sink.write(data.data(), size);
+          if (data.empty()) {
+            // nothing to send, the content length can't be reached
+            return false;
+          }
+
+          sink.write(data.data(), std::min(size, data.size()));
           return ok;
         },
         mime.data());
@@ -181,43 +158,34 @@ class HttpClient : public IHttpClient {
       return {{}, std::move(err)};
     }
 
-    auto content = res->body;
-    return {{content, NormalizeHeaders(std::move(res)).result}};
+    return {{std::move(res->body), NormalizeHeaders(&res->headers)}};
   }
 
   Error Put(std::string_view path, std::string_view body, std::string_view mime) const noexcept override {
-    auto res = client_->Put(AddApiPrefix(path), std::string(body), mime.data());
+    auto res = Acquire()->Put(AddApiPrefix(path), std::string(body), mime.data());
     return CheckRequest(res);
   }
 
   Result<std::tuple<std::string, Headers>> Patch(std::string_view path, std::string_view body,
                                                  Headers headers) const noexcept override {
-    httplib::Headers httplib_headers;
-    for (auto& [k, v] : headers) {
-      httplib_headers.emplace(k, v);
-    }
-    auto res = client_->Patch(AddApiPrefix(path), httplib_headers, std::string(body), "");
+    auto httplib_headers = ToHttplibHeaders(&headers);
+    auto res = Acquire()->Patch(AddApiPrefix(path), httplib_headers, std::string(body), "");
     if (auto err = CheckRequest(res)) {
       return {{}, std::move(err)};
     }
 
-    auto content = res->body;
-    return {{content, NormalizeHeaders(std::move(res)).result}};
+    return {{std::move(res->body), NormalizeHeaders(&res->headers)}};
   }
 
   Result<std::tuple<std::string, Headers>> Delete(std::string_view path, Headers headers) const noexcept override {
-    httplib::Headers httplib_headers;
-    for (auto& [k, v] : headers) {
-      httplib_headers.emplace(k, v);
-    }
+    auto httplib_headers = ToHttplibHeaders(&headers);
 
-    auto res = client_->Delete(AddApiPrefix(path), httplib_headers);
+    auto res = Acquire()->Delete(AddApiPrefix(path), httplib_headers);
     if (auto err = CheckRequest(res)) {
       return {{}, std::move(err)};
     }
 
-    auto content = res->body;
-    return {{content, NormalizeHeaders(std::move(res)).result}};
+    return {{std::move(res->body), NormalizeHeaders(&res->headers)}};
   }
 
   [[nodiscard]] std::optional<std::string> ApiVersion() const noexcept override {
@@ -236,6 +204,7 @@ class HttpClient : public IHttpClient {
       return Error{.code = -1, .message = httplib::to_string(res.error())};
     }
 
+    DetectRequestCompression(res->headers);
     auto status = res->status;
     if (status != 200) {
       auto msg = res->headers.find(std::string(kHeaderError));
@@ -274,20 +243,137 @@ class HttpClient : public IHttpClient {
     return Error::kOk;
   }
 
+  /**
+   * The server advertises the encodings of request bodies it decodes with Accept-Encoding in responses (RFC 7694),
+   * the request bodies are compressed only after it accepted gzip, unless HttpOptions::force_request_compression is set
+   */
+  void DetectRequestCompression(const httplib::Headers& headers) const noexcept {
+    if (options_.request_compression != Compression::kGzip || server_accepts_gzip_) {
+      return;
+    }
+
+    auto [begin, end] = headers.equal_range("Accept-Encoding");
+    if (std::any_of(begin, end, [](const auto& header) { return header.second.find("gzip") != std::string::npos; })) {
+      server_accepts_gzip_ = true;
+    }
+  }
+
   std::string AddApiPrefix(std::string_view path) const { return fmt::format("{}{}", api_prefix_, path); }
 
-  std::unique_ptr<httplib::Client> client_;
+  /**
+   * Connection leased from the pool, it goes back to the pool when the request is done
+   */
+  class Connection {
+   public:
+    Connection(const HttpClient* owner, std::unique_ptr<httplib::Client> client)
+        : owner_(owner), client_(std::move(client)) {}
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    ~Connection() { owner_->Release(std::move(client_)); }
+
+    httplib::Client* operator->() const { return client_.get(); }
+
+   private:
+    const HttpClient* owner_;
+    std::unique_ptr<httplib::Client> client_;
+  };
+
+  /**
+   * Take an idle connection from the pool or open a new one, so concurrent requests don't wait for each other
+   */
+  Connection Acquire() const {
+    std::unique_ptr<httplib::Client> client;
+    {
+      std::lock_guard lock(pool_mutex_);
+      if (!idle_connections_.empty()) {
+        client = std::move(idle_connections_.back());
+        idle_connections_.pop_back();
+      }
+    }
+
+    if (!client) {
+      client = MakeConnection();
+    }
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+    client->set_compress(server_accepts_gzip_);
+#endif
+    return {this, std::move(client)};
+  }
+
+  /**
+   * Return a connection to the pool, it is closed if the pool already keeps the maximum number of connections
+   */
+  void Release(std::unique_ptr<httplib::Client> client) const {
+    std::lock_guard lock(pool_mutex_);
+    if (idle_connections_.size() < std::max<size_t>(options_.max_connections, 1)) {
+      idle_connections_.push_back(std::move(client));
+    }
+  }
+
+  std::unique_ptr<httplib::Client> MakeConnection() const {
+    auto client = std::make_unique<httplib::Client>(base_url_);
+    client->enable_server_certificate_verification(options_.ssl_verification);
+    client->set_keep_alive(true);
+
+    if (!options_.api_token.empty()) {
+      client->set_bearer_token_auth(options_.api_token);
+    }
+
+    // httplib built with zlib asks for compressed responses by default, so the encoding is always set explicitly
+    std::string accept_encoding = "identity";
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+    if (options_.response_compression == Compression::kGzip) {
+      accept_encoding = "gzip";
+    }
+#endif
+    client->set_default_headers({{"Accept-Encoding", accept_encoding}});
+
+    if (options_.connection_timeout.has_value()) {
+      client->set_connection_timeout(
+          std::chrono::duration_cast<std::chrono::seconds>(options_.connection_timeout.value()).count());
+    }
+
+    if (options_.request_timeout.has_value()) {
+      client->set_read_timeout(
+          std::chrono::duration_cast<std::chrono::seconds>(options_.request_timeout.value()).count());
+      client->set_write_timeout(
+          std::chrono::duration_cast<std::chrono::seconds>(options_.request_timeout.value()).count());
+    }
+
+    return client;
+  }
+
+  HttpOptions options_;
+  std::string base_url_;
+  mutable std::vector<std::unique_ptr<httplib::Client>> idle_connections_;
+  mutable std::mutex pool_mutex_;
   std::string api_token_;
   std::string api_prefix_;
   mutable std::string access_token_;
   mutable std::optional<std::string> api_version_;
   mutable std::mutex api_version_mutex_;
+  mutable std::atomic<bool> server_accepts_gzip_ = false;  // request bodies may be compressed
 };
 
 std::unique_ptr<IHttpClient> IHttpClient::Build(std::string_view url, const HttpOptions& options) {
   return std::make_unique<HttpClient>(url, options);
 }
 
+std::ranges::subrange<IHttpClient::Headers::const_iterator> HeadersWithPrefix(const IHttpClient::Headers& headers,
+                                                                             std::string_view prefix) {
+  if (prefix.empty()) {
+    return {headers.begin(), headers.end()};
+  }
+
+  // the names with the prefix are between the prefix and the prefix with the next last character
+  std::string next_prefix(prefix);
+  next_prefix.back() = static_cast<char>(HeaderNameLess::ToLower(next_prefix.back()) + 1);
+  return {headers.lower_bound(prefix), headers.lower_bound(next_prefix)};
+}
+
 bool IsCompatible(std::string_view min, std::string_view version) {
   if (version.empty()) {
     return false;
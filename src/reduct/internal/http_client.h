@@ -3,9 +3,13 @@
 #ifndef REDUCT_CPP_HTTP_CLIENT_H
 #define REDUCT_CPP_HTTP_CLIENT_H
 
+#include <algorithm>
 #include <functional>
+#include <map>
 #include <memory>
 #include <optional>
+#include <ranges>
+#include <string>
 #include <string_view>
 
 #include "reduct/http_options.h"
@@ -13,16 +17,38 @@
 
 namespace reduct::internal {
 
+/**
+ * Case-insensitive order of HTTP header names, a header may be looked up by a string view
+ */
+struct HeaderNameLess {
+  using is_transparent = void;
+
+  static constexpr char ToLower(char ch) noexcept { return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch + 32) : ch; }
+
+  bool operator()(std::string_view lhs, std::string_view rhs) const noexcept {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                                        [](char l, char r) { return ToLower(l) < ToLower(r); });
+  }
+};
+
 /**
  * Wrapper for HTTP client
  */
 class IHttpClient {
  public:
   virtual Result<std::string> Get(std::string_view path) const noexcept = 0;
-  using WriteCallback = std::function<std::pair<bool, std::string>(size_t offset, size_t size)>;
+  /**
+   * Called when the client is ready to send a chunk of a body.
+   * Returns false to stop and a view of the data to send, the view may be shorter than the requested size
+   * and must be valid until the next call.
+   */
+  using WriteCallback = std::function<std::pair<bool, std::string_view>(size_t offset, size_t size)>;
 
   using ReadCallback = std::function<bool(std::string_view)>;
-  using Headers = std::unordered_map<std::string, std::string>;
+  /**
+   * Headers keep the names as they were received, they are sorted and compared case-insensitively
+   */
+  using Headers = std::map<std::string, std::string, HeaderNameLess>;
   using ResponseCallback = std::function<void(Headers &&)>;
 
   virtual Error Get(std::string_view path, ResponseCallback, ReadCallback) const noexcept = 0;
@@ -58,6 +84,12 @@ class IHttpClient {
   static std::unique_ptr<IHttpClient> Build(std::string_view url, const HttpOptions &options);
 };
 
+/**
+ * Headers whose names start with the prefix (case-insensitive), found without scanning the other headers
+ */
+std::ranges::subrange<IHttpClient::Headers::const_iterator> HeadersWithPrefix(const IHttpClient::Headers& headers,
+                                                                             std::string_view prefix);
+
 bool IsCompatible(std::string_view min, std::string_view version);
 
 }  // namespace reduct::internal
@@ -0,0 +1,503 @@
+// Copyright 2026 ReductSoftware UG
+
+#include <catch2/catch.hpp>
+#include <fmt/core.h>
+
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "reduct/bucket.h"
+#include "reduct/executor.h"
+#include "reduct/internal/batch_v1.h"
+#include "reduct/internal/batch_v2.h"
+#include "reduct/internal/codec.h"
+#include "stub_server.h"
+
+using reduct::BatchLimits;
+using reduct::Compression;
+using reduct::Error;
+using reduct::IBucket;
+using reduct::IExecutor;
+using reduct::internal::BatchBodyReader;
+using reduct::internal::ChunkQueue;
+using reduct::internal::DecodeRecords;
+using reduct::internal::FromMicroseconds;
+using reduct::internal::HeadersWithPrefix;
+using reduct::internal::IHttpClient;
+using reduct::internal::ParseAndBuildBatchedRecordsV2;
+using reduct::internal::SendBatchParts;
+using reduct::internal::SplitBatch;
+using us = std::chrono::microseconds;
+
+namespace {
+
+std::string ReadAll(BatchBodyReader* reader, size_t content_length, size_t chunk_size) {
+  std::string body;
+  while (body.size() < content_length) {
+    auto data = reader->Read(body.size(), chunk_size);
+    if (data.empty()) {
+      break;
+    }
+    body.append(data);
+  }
+  return body;
+}
+
+IHttpClient::Headers MakeBatchedHeadersV2(size_t count) {
+  IHttpClient::Headers headers;
+  headers["x-reduct-entries"] = "entry";
+  headers["x-reduct-start-ts"] = "0";
+  headers["x-reduct-labels"] = "sensor,unit,site,line,state";
+  headers["x-reduct-0-0"] = "100,application/octet-stream,0=temp-1,1=celsius,2=berlin,3=line-4,4=ok";
+  for (size_t i = 1; i < count; ++i) {
+    // the state changes from time to time, the other records repeat the previous header
+    headers[fmt::format("x-reduct-0-{}", i)] =
+        i % 100 == 0 ? fmt::format("100,,4={}", i % 200 ? "warn" : "ok") : "100";
+  }
+  return headers;
+}
+
+}  // namespace
+
+TEST_CASE("reduct::internal::BatchBodyReader should read body in order", "[batch]") {
+  IBucket::Batch batch;
+  batch.AddRecord(IBucket::Time(), "1111111111");
+  batch.AddRecord(IBucket::Time() + us(1));
+  batch.AddRecord(IBucket::Time() + us(2), "2222222222");
+  batch.AddRecord(IBucket::Time() + us(3), "3333333333");
+
+  SECTION("small chunks") {
+    BatchBodyReader reader(batch, {0, 1, 2, 3});
+    REQUIRE(reader.Read(0, 6) == "111111");
+    REQUIRE(reader.Read(6, 6) == "111122");
+    REQUIRE(reader.Read(12, 6) == "222222");
+    REQUIRE(reader.Read(18, 20) == "223333333333");
+    REQUIRE(reader.Read(30, 6).empty());
+  }
+
+  SECTION("whole body") {
+    BatchBodyReader reader(batch, {0, 1, 2, 3});
+    REQUIRE(ReadAll(&reader, 30, 1000) == "111111111122222222223333333333");
+    REQUIRE(reader.Read(30, 10).empty());
+  }
+
+  SECTION("custom order") {
+    BatchBodyReader reader(batch, {3, 1, 0, 2});
+    REQUIRE(ReadAll(&reader, 30, 7) == "333333333311111111112222222222");
+  }
+
+  SECTION("seek") {
+    BatchBodyReader reader(batch, {0, 1, 2, 3});
+    REQUIRE(reader.Read(25, 10) == "33333");
+    REQUIRE(reader.Read(5, 10) == "1111122222");
+    REQUIRE(reader.Read(15, 3) == "222");
+    REQUIRE(reader.Read(40, 10).empty());
+  }
+}
+
+TEST_CASE("reduct::internal::BatchBodyReader should not copy big records", "[batch]") {
+  IBucket::Batch batch;
+  batch.AddRecord(IBucket::Time(), "1111111111");
+  batch.AddRecord(IBucket::Time() + us(1), std::string(100'000, '2'));
+
+  BatchBodyReader reader(batch, {0, 1});
+  REQUIRE(reader.Read(0, 512'000) == "1111111111");
+
+  auto data = reader.Read(10, 512'000);
+  REQUIRE(data.size() == 100'000);
+  REQUIRE(data == std::string(100'000, '2'));
+  REQUIRE(reader.Read(100'010, 512'000).empty());
+}
+
+TEST_CASE("reduct::IBucket::Batch should move big records without copying", "[batch]") {
+  IBucket::Batch batch;
+  std::string big(100'000, '2');
+  const auto* big_data = big.data();
+  std::string copied(100'000, '3');
+
+  batch.AddRecord(IBucket::Time(), std::string("1111111111"));
+  batch.AddRecord(IBucket::Time() + us(1), std::move(big));
+  batch.AddRecord(IBucket::Time() + us(2), copied);
+  batch.AddRecord(IBucket::Time() + us(3), "4444");
+
+  REQUIRE(batch.size() == 200'014);
+  REQUIRE(batch.records()[0].data_offset == 0);
+  REQUIRE(batch.records()[1].moved_data == 0);
+  REQUIRE(batch.record_data(1).data() == big_data);
+  REQUIRE(batch.records()[2].data_offset == 10);
+  REQUIRE(batch.record_data(2) == copied);
+
+  REQUIRE(batch.Slice(99'990, 30) == std::string(20, '2') + std::string(10, '3'));
+  REQUIRE(batch.Slice(200'005, 20) == "333334444");
+  REQUIRE(batch.Slice(std::vector<size_t>{3, 1}, 0, 6) == "444422");
+
+  BatchBodyReader reader(batch, {0, 1, 2, 3});
+  REQUIRE(ReadAll(&reader, batch.size(), 512'000) ==
+          "1111111111" + std::string(100'000, '2') + copied + "4444");
+}
+
+TEST_CASE("reduct::IBucket::Batch should be reused after Clear", "[batch]") {
+  IBucket::Batch batch;
+  batch.Reserve(2, 20);
+  batch.AddRecord("entry-1", IBucket::Time(), "1111111111");
+  batch.AddRecord("entry-2", IBucket::Time() + us(1));
+  batch.AddRecord("entry-1", IBucket::Time() + us(2), "2222222222");
+
+  REQUIRE(batch.size() == 20);
+  REQUIRE(batch.record_data(0) == "1111111111");
+  REQUIRE(batch.record_data(1).empty());
+  REQUIRE(batch.record_data(2) == "2222222222");
+
+  batch.Clear();
+  REQUIRE(batch.records().empty());
+  REQUIRE(batch.size() == 0);
+
+  batch.AddRecord(IBucket::Time(), "333");
+  REQUIRE(batch.records().size() == 1);
+  REQUIRE(batch.record_data(0) == "333");
+  REQUIRE(batch.Slice(0, 10) == "333");
+}
+
+TEST_CASE("reduct::internal::SplitBatch should split batch by limits", "[batch]") {
+  IBucket::Batch batch;
+  for (int i = 0; i < 10; ++i) {
+    batch.AddRecord(IBucket::Time() + us(i), std::string(10, 'x'));
+  }
+
+  std::vector<size_t> ordered(10);
+  std::iota(ordered.begin(), ordered.end(), 0);
+  const std::vector<size_t> header_sizes(10, 100);
+
+  SECTION("no split") {
+    auto parts = SplitBatch(batch, ordered, header_sizes, true, {});
+    REQUIRE(parts == std::vector<std::vector<size_t>>{ordered});
+  }
+
+  SECTION("by records") {
+    auto parts = SplitBatch(batch, ordered, header_sizes, true, {.max_records = 4});
+    REQUIRE(parts == std::vector<std::vector<size_t>>{{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9}});
+  }
+
+  SECTION("by header size") {
+    auto parts = SplitBatch(batch, ordered, header_sizes, true, {.max_header_size = 500});
+    REQUIRE(parts == std::vector<std::vector<size_t>>{{0, 1, 2, 3, 4}, {5, 6, 7, 8, 9}});
+  }
+
+  SECTION("by body size") {
+    auto parts = SplitBatch(batch, ordered, header_sizes, true, {.max_body_size = 35});
+    REQUIRE(parts.size() == 4);
+    REQUIRE(parts[0] == std::vector<size_t>{0, 1, 2});
+
+    // no body for updates and removals
+    REQUIRE(SplitBatch(batch, ordered, header_sizes, false, {.max_body_size = 35}).size() == 1);
+  }
+
+  SECTION("record bigger than limit") {
+    auto parts = SplitBatch(batch, {0, 1}, header_sizes, true, {.max_body_size = 5});
+    REQUIRE(parts == std::vector<std::vector<size_t>>{{0}, {1}});
+  }
+}
+
+TEST_CASE("reduct::internal::SendBatchParts should send all parts", "[batch]") {
+  std::mutex mutex;
+  std::set<size_t> sent;
+  auto send = [&](size_t part) {
+    std::lock_guard lock(mutex);
+    sent.insert(part);
+    return Error::kOk;
+  };
+
+  SECTION("sequentially") {
+    REQUIRE(SendBatchParts(10, 1, nullptr, send) == std::vector<Error>(10));
+    REQUIRE(sent.size() == 10);
+  }
+
+  SECTION("in parallel") {
+    auto executor = IExecutor::Build(3);
+    REQUIRE(SendBatchParts(10, 4, executor.get(), send) == std::vector<Error>(10));
+    REQUIRE(sent.size() == 10);
+  }
+
+  SECTION("stop after error") {
+    const auto too_large = Error{.code = 413, .message = "Too large"};
+    auto errors = SendBatchParts(10, 1, nullptr, [&](size_t part) {
+      auto send_err = send(part);
+      return part == 2 ? too_large : send_err;
+    });
+
+    REQUIRE(sent == std::set<size_t>{0, 1, 2});
+    REQUIRE(errors[0] == Error::kOk);
+    REQUIRE(errors[1] == Error::kOk);
+    for (size_t i = 2; i < 10; ++i) {
+      REQUIRE(errors[i] == too_large);
+    }
+  }
+}
+
+TEST_CASE("reduct::IBucket should report the records of failed parts of a split batch", "[batch]") {
+  StubServer server;
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  auto write_batch = [ts](const IBucket& bucket) {
+    return bucket.WriteBatch("entry", [ts](IBucket::Batch* batch) {
+      for (int i = 0; i < 6; ++i) {
+        batch->AddRecord(ts + us(i), "data");
+      }
+    });
+  };
+
+  // the first part of two records is written, the next one fails and the last one isn't sent
+  server.fail_batches_after(1);
+
+  SECTION("sequentially") {
+    auto bucket = IBucket::Build(server.url(), "test_bucket", {.batch_limits = {.max_records = 2}});
+    auto [errors, err] = write_batch(*bucket);
+
+    REQUIRE(err.code == 503);
+    REQUIRE(errors.size() == 4);
+    for (int i = 2; i < 6; ++i) {
+      REQUIRE(errors[ts + us(i)] == err);
+    }
+    REQUIRE(server.record_count("entry") == 2);
+  }
+
+  SECTION("in parallel") {
+    auto bucket = IBucket::Build(server.url(), "test_bucket",
+                                 {.batch_limits = {.max_records = 2, .max_parallel_requests = 3}});
+    auto [errors, err] = write_batch(*bucket);
+
+    REQUIRE(err.code == 503);
+    REQUIRE(errors.size() == 4);
+    REQUIRE(server.record_count("entry") == 2);
+  }
+
+  SECTION("not split without limits") {
+    auto bucket = IBucket::Build(server.url(), "test_bucket", {});
+    auto [errors, err] = write_batch(*bucket);
+
+    REQUIRE(err == Error::kOk);
+    REQUIRE(errors.empty());
+    REQUIRE(server.record_count("entry") == 6);
+  }
+}
+
+TEST_CASE("reduct::internal::ParseAndBuildBatchedRecordsV2 should share labels", "[batch]") {
+  ChunkQueue data;
+  IHttpClient::Headers headers;
+  headers["x-reduct-entries"] = "entry";
+  headers["x-reduct-start-ts"] = "0";
+  headers["x-reduct-0-0"] = "1,text/plain,a=1,b=2";
+  headers["x-reduct-0-1"] = "1";
+  headers["x-reduct-0-2"] = "1,,b=3";
+
+  SECTION("copy") {
+    auto records = ParseAndBuildBatchedRecordsV2(&data, true, IHttpClient::Headers(headers));
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0].labels == IBucket::LabelMap{{"a", "1"}, {"b", "2"}});
+    REQUIRE(records[1].labels == IBucket::LabelMap{{"a", "1"}, {"b", "2"}});
+    REQUIRE(records[2].labels == IBucket::LabelMap{{"a", "1"}, {"b", "3"}});
+    REQUIRE(records[0].shared_labels == nullptr);
+  }
+
+  SECTION("share") {
+    auto records = ParseAndBuildBatchedRecordsV2(&data, true, IHttpClient::Headers(headers), true);
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0].labels.empty());
+    REQUIRE(records[0].shared_labels == records[1].shared_labels);
+    REQUIRE(*records[1].shared_labels == IBucket::LabelMap{{"a", "1"}, {"b", "2"}});
+    REQUIRE(*records[2].shared_labels == IBucket::LabelMap{{"a", "1"}, {"b", "3"}});
+  }
+}
+
+TEST_CASE("reduct::internal::FromMicroseconds should parse 64-bit timestamps", "[batch]") {
+  constexpr uint64_t kTimestamp = 1'700'000'000'000'000;
+  REQUIRE(FromMicroseconds(kTimestamp) == IBucket::Time() + us(kTimestamp));
+  REQUIRE(FromMicroseconds(std::string_view("1700000000000000")) == IBucket::Time() + us(kTimestamp));
+  REQUIRE(FromMicroseconds(std::string_view("18446744073709551615")).has_value());
+
+  REQUIRE_FALSE(FromMicroseconds(std::string_view("")));
+  REQUIRE_FALSE(FromMicroseconds(std::string_view("12a")));
+  REQUIRE_FALSE(FromMicroseconds(std::string_view("-1")));
+  REQUIRE_FALSE(FromMicroseconds(std::string_view("18446744073709551616")));
+}
+
+TEST_CASE("reduct::internal::IHttpClient::Headers should be case-insensitive", "[batch]") {
+  IHttpClient::Headers headers;
+  headers["X-Reduct-Entries"] = "entry";
+  headers["x-reduct-start-ts"] = "10";
+  headers["X-REDUCT-0-1"] = "1,text/plain";
+  headers["x-reduct-0-0"] = "1,text/plain";
+  headers["X-Reduct-Last"] = "true";
+  headers["Content-Length"] = "2";
+
+  REQUIRE(headers.find(std::string_view("x-reduct-entries")) != headers.end());
+  REQUIRE(headers["content-length"] == "2");
+
+  std::vector<std::string> names;
+  for (const auto& [name, _] : HeadersWithPrefix(headers, "x-reduct-0-")) {
+    names.push_back(name);
+  }
+  REQUIRE(names == std::vector<std::string>{"x-reduct-0-0", "X-REDUCT-0-1"});
+
+  ChunkQueue data;
+  auto records = ParseAndBuildBatchedRecordsV2(&data, true, std::move(headers));
+  REQUIRE(records.size() == 2);
+  REQUIRE(records[0].timestamp == IBucket::Time() + us(10));
+  REQUIRE(records[1].timestamp == IBucket::Time() + us(11));
+  REQUIRE(records[1].last);
+}
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+TEST_CASE("reduct::IBucket::Batch should compress records", "[batch][compression]") {
+  std::string data;
+  for (int i = 0; i < 10'000; ++i) {
+    data.append(fmt::format("value-{};", i % 100));
+  }
+
+  IBucket::Batch batch;
+  batch.AddRecord(IBucket::Time(), data, Compression::kGzip, "text/plain", {{"key", "value"}});
+  batch.AddRecord(IBucket::Time() + us(1), "abc", Compression::kGzip);
+
+  const auto& records = batch.records();
+  REQUIRE(records[0].content_type == "text/plain");
+  REQUIRE(records[0].labels.at("key") == "value");
+  REQUIRE(records[0].labels.at("content-encoding") == "gzip");
+  REQUIRE(records[0].size < data.size() / 10);
+  REQUIRE_FALSE(records[1].labels.contains("content-encoding"));  // it doesn't become smaller
+
+  // the stored data is received in small chunks
+  auto make_record = [&batch](size_t index) {
+    IBucket::ReadableRecord record;
+    record.labels = batch.records()[index].labels;
+    record.Read = [&batch, index](auto callback) {
+      auto stored = batch.record_data(index);
+      for (size_t offset = 0; offset < stored.size(); offset += 7) {
+        if (!callback(stored.substr(offset, 7))) {
+          break;
+        }
+      }
+      return Error::kOk;
+    };
+    return record;
+  };
+
+  SECTION("and decompress them while reading") {
+    std::vector<std::string> received;
+    auto callback = DecodeRecords([&received](const auto& record) {
+      received.push_back(record.ReadAll().result);
+      return true;
+    });
+
+    REQUIRE(callback(make_record(0)));
+    REQUIRE(callback(make_record(1)));
+    REQUIRE(received == std::vector<std::string>{data, "abc"});
+  }
+
+  SECTION("and stop reading") {
+    size_t chunks = 0;
+    auto callback = DecodeRecords([&chunks](const auto& record) {
+      REQUIRE(record.Read([&chunks](auto) { return ++chunks < 2; }) == Error::kOk);
+      return true;
+    });
+
+    REQUIRE(callback(make_record(0)));
+    REQUIRE(chunks == 2);
+  }
+
+  SECTION("and detect truncated data") {
+    auto record = make_record(0);
+    auto read = record.Read;
+    record.Read = [read](auto callback) {
+      size_t size = 0;
+      return read([&](auto chunk) { return (size += chunk.size()) < 100 && callback(chunk); });
+    };
+
+    Error err;
+    auto callback = DecodeRecords([&err](const auto& record) {
+      err = record.ReadAll().error;
+      return true;
+    });
+
+    REQUIRE(callback(record));
+    REQUIRE(err.message == "Failed to decompress record: gzip data is truncated");
+  }
+}
+#else
+TEST_CASE("reduct::IBucket::Batch should store records as is without zlib", "[batch][compression]") {
+  IBucket::Batch batch;
+  batch.AddRecord(IBucket::Time(), std::string(1'000, 'x'), Compression::kGzip, "text/plain", {{"key", "value"}});
+
+  const auto& records = batch.records();
+  REQUIRE(records[0].labels == IBucket::LabelMap{{"key", "value"}});
+  REQUIRE(batch.record_data(0) == std::string(1'000, 'x'));
+
+  // a record compressed by another client can't be read
+  IBucket::ReadableRecord record;
+  record.labels = {{"content-encoding", "gzip"}};
+  record.Read = [](auto callback) {
+    callback("compressed");
+    return Error::kOk;
+  };
+
+  Error err;
+  auto callback = DecodeRecords([&err](const auto& record) {
+    err = record.ReadAll().error;
+    return true;
+  });
+
+  REQUIRE(callback(record));
+  REQUIRE(err.message == "Record is compressed with gzip, but the library is built without zlib");
+}
+#endif
+
+TEST_CASE("reduct::internal::ParseAndBuildBatchedRecordsV2 performance", "[batch][.benchmark]") {
+  for (size_t count : {1'000, 10'000}) {
+    const auto headers = MakeBatchedHeadersV2(count);
+    ChunkQueue data;
+
+    // the parser consumes the headers, so the copies are made before the measurement
+    for (bool share_labels : {false, true}) {
+      BENCHMARK_ADVANCED(fmt::format("{} labels {} records", share_labels ? "shared" : "copied", count))
+      (Catch::Benchmark::Chronometer meter) {
+        std::vector<IHttpClient::Headers> inputs(meter.runs(), headers);
+        meter.measure([&](int i) {
+          return ParseAndBuildBatchedRecordsV2(&data, true, std::move(inputs[i]), share_labels).size();
+        });
+      };
+    }
+  }
+}
+
+TEST_CASE("reduct::internal::BatchBodyReader performance", "[batch][.benchmark]") {
+  constexpr size_t kChunkSize = 512'000;  // chunk size of the HTTP client
+
+  for (size_t count : {1'000, 10'000, 50'000}) {
+    IBucket::Batch batch;
+    for (size_t i = 0; i < count; ++i) {
+      batch.AddRecord(IBucket::Time() + us(i), std::string(100, 'x'));
+    }
+
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+
+    BENCHMARK(fmt::format("Batch::Slice {} records", count)) {
+      size_t offset = 0;
+      while (offset < batch.size()) {
+        offset += batch.Slice(order, offset, kChunkSize).size();
+      }
+      return offset;
+    };
+
+    BENCHMARK(fmt::format("BatchBodyReader {} records", count)) {
+      BatchBodyReader reader(batch, order);
+      size_t offset = 0;
+      while (offset < batch.size()) {
+        offset += reader.Read(offset, kChunkSize).size();
+      }
+      return offset;
+    };
+  }
+}
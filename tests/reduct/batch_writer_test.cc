@@ -0,0 +1,159 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/batch_writer.h"
+
+#include <catch2/catch.hpp>
+#include <fmt/core.h>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stub_server.h"
+
+using reduct::Error;
+using reduct::IBatchWriter;
+using reduct::IBucket;
+using us = std::chrono::microseconds;
+
+TEST_CASE("reduct::IBatchWriter should write records in batches", "[batch_writer]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+
+  SECTION("by number of records") {
+    auto writer = IBatchWriter::Build(*bucket, {.max_batch_records = 10, .linger = std::chrono::hours(1)});
+
+    std::vector<std::future<Error>> futures;
+    for (int i = 0; i < 20; ++i) {
+      futures.push_back(writer->Write("entry", {.timestamp = ts + us(i)}, fmt::format("data-{}", i)));
+    }
+
+    for (auto& future : futures) {
+      REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+      REQUIRE(future.get() == Error::kOk);
+    }
+
+    REQUIRE(server.record_count("entry") == 20);
+  }
+
+  SECTION("by linger time") {
+    auto writer = IBatchWriter::Build(*bucket, {.linger = std::chrono::milliseconds(10)});
+
+    auto future = writer->Write("entry", {.timestamp = ts}, "data");
+    REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    REQUIRE(future.get() == Error::kOk);
+
+    std::string received;
+    REQUIRE(bucket->Read("entry", ts, [&received](auto record) {
+      received = record.ReadAll().result;
+      return true;
+    }) == Error::kOk);
+    REQUIRE(received == "data");
+  }
+
+  SECTION("from many threads") {
+    auto writer = IBatchWriter::Build(*bucket, {.max_batch_size = 100, .max_buffer_size = 200});
+
+    std::vector<std::thread> threads;
+    std::atomic<int> written = 0;
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back([&, i] {
+        for (int j = 0; j < 10; ++j) {
+          writer->Write("entry", {.timestamp = ts + us(i * 10 + j)}, "0123456789", [&written](Error err) {
+            if (!err) {
+              written++;
+            }
+          });
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    writer->Flush();
+    REQUIRE(written == 80);
+    REQUIRE(server.record_count("entry") == 80);
+  }
+
+  SECTION("with the current time from many threads") {
+    auto writer = IBatchWriter::Build(*bucket, {.max_batch_records = 10});
+
+    std::vector<std::thread> threads;
+    std::atomic<int> written = 0;
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 50; ++j) {
+          writer->Write("entry", {}, "data", [&written](Error err) {
+            if (!err) {
+              written++;
+            }
+          });
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // the records written at the same microsecond get different timestamps
+    writer->Flush();
+    REQUIRE(written == 400);
+    REQUIRE(server.record_count("entry") == 400);
+  }
+
+  SECTION("pipelined") {
+    for (bool keep_order : {false, true}) {
+      IBatchWriter::Options options{.max_batch_records = 5, .max_in_flight = 4, .keep_order = keep_order};
+      auto writer = IBatchWriter::Build(*bucket, options);
+
+      std::vector<std::future<Error>> futures;
+      for (int i = 0; i < 40; ++i) {
+        // one entry per batch, the stub server supports only the batch protocol v1
+        futures.push_back(writer->Write(fmt::format("entry-{}", (i / 5) % 2), {.timestamp = ts + us(i)}, "data"));
+      }
+
+      writer->Flush();
+      for (auto& future : futures) {
+        REQUIRE(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        REQUIRE(future.get() == Error::kOk);
+      }
+    }
+
+    REQUIRE(server.record_count("entry-0") == 20);
+    REQUIRE(server.record_count("entry-1") == 20);
+  }
+
+  SECTION("with a split batch which fails") {
+    auto split_bucket = IBucket::Build(server.url(), "test_bucket", {.batch_limits = {.max_records = 2}});
+    auto writer = IBatchWriter::Build(*split_bucket, {.max_batch_records = 6, .linger = std::chrono::hours(1)});
+    server.fail_batches_after(1);
+
+    std::vector<std::future<Error>> futures;
+    for (int i = 0; i < 6; ++i) {
+      futures.push_back(writer->Write("entry", {.timestamp = ts + us(i)}, "data"));
+    }
+
+    // the records of the written request aren't reported as failed, so they aren't written again
+    writer->Flush();
+    for (int i = 0; i < 6; ++i) {
+      REQUIRE(futures[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+      REQUIRE(futures[i].get().code == (i < 2 ? 0 : 503));
+    }
+    REQUIRE(server.record_count("entry") == 2);
+  }
+
+  SECTION("when destroyed") {
+    auto writer = IBatchWriter::Build(*bucket, {.linger = std::chrono::hours(1)});
+    auto future = writer->Write("entry", {.timestamp = ts}, "data");
+    writer.reset();
+
+    REQUIRE(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    REQUIRE(server.record_count("entry") == 1);
+  }
+}
@@ -2,6 +2,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <cstdlib>
+#include <thread>
 #include <vector>
 
 #include "fixture.h"
@@ -46,6 +48,91 @@ TEST_CASE("reduct::Client should get a bucket", "[bucket_api]") {
   }
 }
 
+TEST_CASE("reduct::IBucket should send concurrent requests through the connection pool", "[bucket_api]") {
+  Fixture ctx;
+
+  reduct::HttpOptions opts{.max_connections = 2};
+  if (auto token = std::getenv("REDUCT_CPP_TOKEN_API")) {
+    opts.api_token = token;
+  }
+
+  auto client = IClient::Build("http://127.0.0.1:8383", opts);
+  auto [bucket, err] = client->CreateBucket(kBucketName);
+  REQUIRE(err == Error::kOk);
+
+  // more threads than pooled connections
+  std::vector<std::thread> threads;
+  std::vector<Error> errors(8);
+  const auto ts = IBucket::Time::clock::now();
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&, i] {
+      const auto entry = fmt::format("entry-{}", i);
+      for (int j = 0; j < 10 && !errors[i]; ++j) {
+        errors[i] = bucket->Write(entry, ts + std::chrono::microseconds(j),
+                                  [&](auto rec) { rec->WriteAll(fmt::format("data-{}-{}", i, j)); });
+        if (errors[i]) {
+          break;
+        }
+
+        Error read_err;
+        errors[i] = bucket->Read(entry, ts + std::chrono::microseconds(j), [&](auto record) {
+          auto [data, err] = record.ReadAll();
+          read_err = err;
+          if (!err && data != fmt::format("data-{}-{}", i, j)) {
+            read_err = Error{.code = -1, .message = "Wrong data"};
+          }
+          return true;
+        });
+
+        if (!errors[i]) {
+          errors[i] = read_err;
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& error : errors) {
+    REQUIRE(error == Error::kOk);
+  }
+}
+
+TEST_CASE("reduct::IBucket should write and read records with compression", "[bucket_api]") {
+  Fixture ctx;
+
+  // request bodies are compressed only if the server advertises gzip
+  reduct::HttpOptions opts{.response_compression = reduct::Compression::kGzip,
+                           .request_compression = reduct::Compression::kGzip};
+  if (auto token = std::getenv("REDUCT_CPP_TOKEN_API")) {
+    opts.api_token = token;
+  }
+
+  auto client = IClient::Build("http://127.0.0.1:8383", opts);
+  auto bucket = client->GetBucket("test_bucket_1").result;
+  REQUIRE(bucket);
+
+  const std::string blob(100'000, 'x');
+  REQUIRE(bucket->Write("entry-3", IBucket::Time() + s(1), [&blob](auto rec) { rec->WriteAll(blob); }) ==
+          Error::kOk);
+
+  std::string received;
+  REQUIRE(bucket->Read("entry-3", IBucket::Time() + s(1), [&received](auto record) {
+    received = record.ReadAll().result;
+    return true;
+  }) == Error::kOk);
+  REQUIRE(received == blob);
+
+  std::vector<std::string> data;
+  REQUIRE(bucket->Query("entry-1", std::nullopt, std::nullopt, {}, [&data](auto record) {
+    data.push_back(record.ReadAll().result);
+    return true;
+  }) == Error::kOk);
+  REQUIRE(data == std::vector<std::string>{"data-1", "data-2"});
+}
+
 TEST_CASE("reduct::Client should get or create a bucket", "[bucket_api]") {
   Fixture ctx;
   [[maybe_unused]] auto _ = ctx.client->GetOrCreateBucket(kBucketName);
@@ -0,0 +1,117 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/internal/chunk_queue.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+using reduct::internal::ChunkQueue;
+
+TEST_CASE("reduct::internal::ChunkQueue should pass chunks in order", "[chunk_queue]") {
+  ChunkQueue queue(4);
+
+  // Catch2 assertions are not thread-safe, so we check the results in the main thread
+  int pushed = 0;
+  std::thread producer([&queue, &pushed] {
+    for (int i = 0; i < 1000; ++i) {
+      pushed += queue.Push(std::to_string(i)) ? 1 : 0;
+    }
+    queue.Close();
+  });
+
+  int expected = 0;
+  while (auto chunk = queue.Front()) {
+    REQUIRE(*chunk == std::to_string(expected++));
+    queue.Consume(chunk->size());
+  }
+
+  producer.join();
+  REQUIRE(pushed == 1000);
+  REQUIRE(expected == 1000);
+  REQUIRE_FALSE(queue.Front());
+}
+
+TEST_CASE("reduct::internal::ChunkQueue should split chunks without copying", "[chunk_queue]") {
+  ChunkQueue queue;
+  REQUIRE(queue.Push("abcdef"));
+  REQUIRE(queue.Push("gh"));
+  queue.Close();
+
+  auto chunk = queue.Front();
+  REQUIRE(chunk);
+  REQUIRE(*chunk == "abcdef");
+  const auto* data = chunk->data();
+  queue.Consume(4);
+
+  chunk = queue.Front();
+  REQUIRE(chunk);
+  REQUIRE(*chunk == "ef");
+  REQUIRE(chunk->data() == data + 4);
+  queue.Consume(1);
+
+  REQUIRE(*queue.Front() == "f");
+  queue.Consume(1);
+  REQUIRE(*queue.Front() == "gh");
+  queue.Consume(2);
+  REQUIRE_FALSE(queue.Front());
+}
+
+TEST_CASE("reduct::internal::ChunkQueue should unblock producer when cancelled", "[chunk_queue]") {
+  ChunkQueue queue(2);
+
+  int pushed = 0;
+  std::thread producer([&queue, &pushed] {
+    for (int i = 0; i < 100; ++i) {
+      pushed += queue.Push("data") ? 1 : 0;
+    }
+    queue.Close();
+  });
+
+  REQUIRE(queue.Front());
+  queue.Cancel();
+  producer.join();
+  REQUIRE(pushed < 100);
+  REQUIRE_FALSE(queue.Front());
+}
+
+TEST_CASE("reduct::internal::ChunkQueue should limit buffered bytes", "[chunk_queue]") {
+  ChunkQueue queue(ChunkQueue::kDefaultCapacity, 8);
+
+  std::atomic<int> started = 0;  // pushes started by the producer
+  std::atomic<int> pushed = 0;   // pushes finished by the producer
+  std::thread producer([&queue, &started, &pushed] {
+    for (int i = 0; i < 4; ++i) {
+      started++;
+      queue.Push("1234");
+      pushed++;
+    }
+    queue.Close();
+  });
+
+  // two chunks fit the limit, the third one can't be pushed until the consumer takes a chunk
+  while (started < 3) {
+    std::this_thread::yield();
+  }
+  REQUIRE(pushed == 2);
+
+  std::string received;
+  while (auto chunk = queue.Front()) {
+    received.append(*chunk);
+    queue.Consume(chunk->size());
+  }
+
+  producer.join();
+  REQUIRE(pushed == 4);
+  REQUIRE(received == "1234123412341234");
+}
+
+TEST_CASE("reduct::internal::ChunkQueue should accept a chunk bigger than the limit", "[chunk_queue]") {
+  ChunkQueue queue(ChunkQueue::kDefaultCapacity, 2);
+  REQUIRE(queue.Push("1234"));
+  queue.Close();
+
+  REQUIRE(*queue.Front() == "1234");
+}
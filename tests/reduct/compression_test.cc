@@ -0,0 +1,142 @@
+// Copyright 2026 ReductSoftware UG
+
+#include <catch2/catch.hpp>
+#include <fmt/core.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "reduct/bucket.h"
+#include "stub_server.h"
+
+using reduct::Compression;
+using reduct::Error;
+using reduct::IBucket;
+using us = std::chrono::microseconds;
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+TEST_CASE("reduct::IBucket should compress requests after the server accepts gzip", "[compression]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {.request_compression = Compression::kGzip});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  const std::string blob(100'000, 'x');
+
+  // the client doesn't know yet if the server decodes compressed bodies
+  REQUIRE(bucket->Write("entry", ts, [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  REQUIRE(server.compressed_requests() == 0);
+
+  REQUIRE(bucket->Write("entry", ts + us(1), [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  auto [batch_errors, batch_err] = bucket->WriteBatch("entry", [&blob, ts](IBucket::Batch* batch) {
+    batch->AddRecord(ts + us(2), blob);
+    batch->AddRecord(ts + us(3), blob);
+  });
+  REQUIRE(batch_err == Error::kOk);
+  REQUIRE(batch_errors.empty());
+  REQUIRE(server.compressed_requests() == 2);
+
+  std::vector<std::string> received;
+  REQUIRE(bucket->Query("entry", std::nullopt, std::nullopt, {}, [&received](auto record) {
+    received.push_back(record.ReadAll().result);
+    return true;
+  }) == Error::kOk);
+  REQUIRE(received == std::vector<std::string>(4, blob));
+}
+
+TEST_CASE("reduct::IBucket should compress requests from the first one if forced", "[compression]") {
+  StubServer server;
+  // a server which doesn't advertise gzip with Accept-Encoding, like ReductStore, gets compressed bodies only so
+  auto bucket = IBucket::Build(server.url(), "test_bucket",
+                               {.request_compression = Compression::kGzip, .force_request_compression = true});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  const std::string blob(100'000, 'x');
+
+  REQUIRE(bucket->Write("entry", ts, [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  REQUIRE(server.compressed_requests() == 1);
+
+  std::string received;
+  REQUIRE(bucket->Read("entry", ts, [&received](auto record) {
+    received = record.ReadAll().result;
+    return true;
+  }) == Error::kOk);
+  REQUIRE(received == blob);
+}
+
+TEST_CASE("reduct::IBucket should read records with compressed responses", "[compression]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {.response_compression = Compression::kGzip});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  const std::string blob(100'000, 'x');
+
+  REQUIRE(bucket->Write("entry", ts, [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  REQUIRE(bucket->Write("entry", ts + us(1), [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+
+  SECTION("single record") {
+    // the size of a single record is its content length, so it is read without compression
+    std::string received;
+    size_t size = 0;
+    REQUIRE(bucket->Read("entry", ts, [&received, &size](auto record) {
+      size = record.size;
+      received = record.ReadAll().result;
+      return true;
+    }) == Error::kOk);
+
+    REQUIRE(size == blob.size());
+    REQUIRE(received == blob);
+  }
+
+  SECTION("query") {
+    std::vector<std::string> received;
+    std::vector<size_t> sizes;
+    REQUIRE(bucket->Query("entry", std::nullopt, std::nullopt, {}, [&received, &sizes](auto record) {
+      sizes.push_back(record.size);
+      received.push_back(record.ReadAll().result);
+      return true;
+    }) == Error::kOk);
+
+    REQUIRE(server.compressed_responses() == 1);
+    REQUIRE(sizes == std::vector<size_t>(2, blob.size()));
+    REQUIRE(received == std::vector<std::string>(2, blob));
+  }
+}
+
+TEST_CASE("reduct::IBucket compression throughput", "[compression][.benchmark]") {
+  constexpr size_t kRecords = 10;
+  constexpr size_t kRecordSize = 1'000'000;
+
+  std::mt19937 random(42);
+  std::string incompressible(kRecordSize, '\0');
+  for (auto& byte : incompressible) {
+    byte = static_cast<char>(random());
+  }
+
+  StubServer server;
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  for (const auto& [kind, data] : {std::pair<std::string, std::string>{"compressible", std::string(kRecordSize, 'x')},
+                                   {"incompressible", incompressible}}) {
+    for (auto compression : {Compression::kNone, Compression::kGzip}) {
+      const auto name = compression == Compression::kGzip ? "gzip" : "identity";
+
+      // the records are compressed by the batch and stored as is if they don't become smaller
+      BENCHMARK(fmt::format("Batch::AddRecord {} MB {} with {}", kRecords, kind, name)) {
+        IBucket::Batch batch;
+        for (size_t i = 0; i < kRecords; ++i) {
+          batch.AddRecord(ts + us(i), data, compression);
+        }
+        return batch.size();
+      };
+
+      auto bucket = IBucket::Build(server.url(), "test_bucket",
+                                   {.request_compression = compression, .force_request_compression = true});
+      BENCHMARK(fmt::format("WriteBatch {} MB {} with {} requests", kRecords, kind, name)) {
+        auto [errors, err] = bucket->WriteBatch("entry", [&data, ts](IBucket::Batch* batch) {
+          for (size_t i = 0; i < kRecords; ++i) {
+            batch->AddRecord(ts + us(i), data);
+          }
+        });
+        return err.code;
+      };
+    }
+  }
+}
+#endif
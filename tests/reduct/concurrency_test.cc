@@ -0,0 +1,308 @@
+// Copyright 2026 ReductSoftware UG
+
+#include <catch2/catch.hpp>
+#include <fmt/core.h>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "reduct/bucket.h"
+#include "stub_server.h"
+
+using reduct::Error;
+using reduct::IBucket;
+using reduct::IExecutor;
+using us = std::chrono::microseconds;
+
+TEST_CASE("reduct::IBucket should be used from many threads", "[concurrency]") {
+  constexpr int kThreads = 32;
+  constexpr int kRecords = 10;
+
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {.max_connections = 8}, std::nullopt, IExecutor::Build(4));
+
+  std::vector<std::thread> threads;
+  std::vector<Error> errors(kThreads);
+  std::vector<int> received(kThreads);
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i] {
+      const auto entry = fmt::format("entry-{}", i);
+      for (int j = 0; j < kRecords && !errors[i]; ++j) {
+        errors[i] = bucket->Write(entry, ts + us(j), [](auto rec) { rec->WriteAll("single"); });
+      }
+
+      if (errors[i]) {
+        return;
+      }
+
+      auto [batch_errors, batch_err] = bucket->WriteBatch(entry, [&](IBucket::Batch* batch) {
+        for (int j = kRecords; j < 2 * kRecords; ++j) {
+          batch->AddRecord(ts + us(j), "batched");
+        }
+      });
+
+      errors[i] = batch_err;
+      if (errors[i]) {
+        return;
+      }
+
+      errors[i] = bucket->Query(entry, std::nullopt, std::nullopt, {}, [&](auto record) {
+        received[i]++;
+        return true;
+      });
+    });
+  }
+
+  // rename the bucket while the other threads use it
+  threads.emplace_back([&] {
+    for (int i = 0; i < 100; ++i) {
+      [[maybe_unused]] auto err = bucket->Rename(fmt::format("test_bucket_{}", i));
+    }
+  });
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < kThreads; ++i) {
+    REQUIRE(errors[i] == Error::kOk);
+    REQUIRE(received[i] == 2 * kRecords);
+    REQUIRE(server.record_count(fmt::format("entry-{}", i)) == 2 * kRecords);
+  }
+}
+
+TEST_CASE("reduct::IBucket should run many asynchronous operations on a few threads", "[concurrency]") {
+  constexpr int kRecords = 1000;
+
+  StubServer server;
+  auto bucket =
+      IBucket::Build(server.url(), "test_bucket", {.max_connections = 4}, std::nullopt, nullptr, IExecutor::Build(4));
+
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  std::vector<std::future<Error>> writes;
+  for (int i = 0; i < kRecords; ++i) {
+    writes.push_back(bucket->WriteAsync("entry", {.timestamp = ts + us(i)},
+                                        [i](auto rec) { rec->WriteAll(fmt::format("data-{}", i)); }));
+  }
+
+  auto batch = bucket->WriteBatchAsync("entry", [&](IBucket::Batch* batch) {
+    for (int i = kRecords; i < 2 * kRecords; ++i) {
+      batch->AddRecord(ts + us(i), fmt::format("data-{}", i));
+    }
+  });
+
+  for (auto& write : writes) {
+    REQUIRE(write.get() == Error::kOk);
+  }
+  REQUIRE(batch.get().error == Error::kOk);
+
+  std::string data;
+  REQUIRE(bucket
+              ->ReadAsync("entry", ts + us(10),
+                          [&data](auto record) {
+                            data = record.ReadAll().result;
+                            return true;
+                          })
+              .get() == Error::kOk);
+  REQUIRE(data == "data-10");
+
+  std::promise<Error> query_done;
+  std::atomic<int> received = 0;
+  bucket->QueryAsync(
+      "entry", std::nullopt, std::nullopt, {},
+      [&received](auto record) {
+        received++;
+        return true;
+      },
+      [&query_done](Error err) { query_done.set_value(std::move(err)); });
+
+  REQUIRE(query_done.get_future().get() == Error::kOk);
+  REQUIRE(received == 2 * kRecords);
+}
+
+TEST_CASE("reduct::IBucket should prefetch pages on the I/O executor", "[concurrency]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {}, std::nullopt, nullptr, IExecutor::Build(1));
+
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(bucket->Write("entry", ts + us(i), [i](auto rec) { rec->WriteAll(fmt::format("data-{}", i)); }) ==
+            Error::kOk);
+  }
+
+  std::vector<std::string> received;
+  auto callback = [&received](auto record) {
+    received.push_back(record.ReadAll().result);
+    return true;
+  };
+
+  SECTION("from another thread") {
+    REQUIRE(bucket->Query("entry", std::nullopt, std::nullopt, {.prefetch_pages = 2}, callback) == Error::kOk);
+  }
+
+  SECTION("from the only thread of the executor") {
+    // the query can't wait for a reader on its own executor, it reads the pages itself
+    auto future = bucket->QueryAsync("entry", std::nullopt, std::nullopt, {.prefetch_pages = 2}, callback);
+    REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    REQUIRE(future.get() == Error::kOk);
+  }
+
+  REQUIRE(received.size() == 10);
+  REQUIRE(received[9] == "data-9");
+}
+
+TEST_CASE("reduct::IBucket should be destroyed in a completion callback", "[concurrency]") {
+  StubServer server;
+  // the bucket owns its executors, the last completion destroys them on their own thread
+  std::unique_ptr<IBucket> bucket = IBucket::Build(server.url(), "test_bucket", {});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+
+  std::promise<Error> destroyed;
+  bucket->WriteAsync(
+      "entry", {.timestamp = ts}, [](auto rec) { rec->WriteAll("data"); },
+      [&bucket, &destroyed](Error err) {
+        bucket.reset();
+        destroyed.set_value(std::move(err));
+      });
+
+  auto future = destroyed.get_future();
+  REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  REQUIRE(future.get() == Error::kOk);
+  REQUIRE(bucket == nullptr);
+  REQUIRE(server.record_count("entry") == 1);
+}
+
+TEST_CASE("reduct::IBucket should read from a record callback", "[concurrency]") {
+  StubServer server;
+  // the buckets of a client share one callback executor with one thread
+  auto executor = IExecutor::Build(1);
+  auto outer = IBucket::Build(server.url(), "test_bucket_1", {}, std::nullopt, executor);
+  auto inner = IBucket::Build(server.url(), "test_bucket_2", {}, std::nullopt, executor);
+
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  REQUIRE(outer->Write("outer", ts, [](auto rec) { rec->WriteAll("outer-data"); }) == Error::kOk);
+  REQUIRE(inner->Write("inner", ts, [](auto rec) { rec->WriteAll("inner-data"); }) == Error::kOk);
+
+  auto query = std::async(std::launch::async, [&] {
+    std::vector<std::string> received;
+    std::vector<Error> errors;
+    errors.push_back(outer->Query("outer", std::nullopt, std::nullopt, {}, [&](auto record) {
+      received.push_back(record.ReadAll().result);
+      errors.push_back(inner->Read("inner", ts, [&](auto inner_record) {
+        received.push_back(inner_record.ReadAll().result);
+        return true;
+      }));
+      errors.push_back(inner->Query("inner", std::nullopt, std::nullopt, {}, [&](auto inner_record) {
+        received.push_back(inner_record.ReadAll().result);
+        return true;
+      }));
+      return true;
+    }));
+    return std::pair{errors, received};
+  });
+
+  REQUIRE(query.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  auto [errors, received] = query.get();
+  REQUIRE(errors == std::vector<Error>(3, Error::kOk));
+  REQUIRE(received == std::vector<std::string>{"outer-data", "inner-data", "inner-data"});
+}
+
+TEST_CASE("reduct::IBucket should read a chunked record from a record callback", "[concurrency]") {
+  StubServer server;
+  auto executor = IExecutor::Build(1);
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {}, std::nullopt, executor);
+
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  REQUIRE(bucket->Write("outer", ts, [](auto rec) { rec->WriteAll("outer-data"); }) == Error::kOk);
+  REQUIRE(bucket->Write("inner", ts, [](auto rec) { rec->WriteAll("inner-data"); }) == Error::kOk);
+
+  // without the content length, the record is read inline to the end of the body
+  server.chunked_records(true);
+  std::string received;
+  size_t size = 0;
+  auto err = bucket->Query("outer", std::nullopt, std::nullopt, {}, [&](auto) {
+    REQUIRE(bucket->Read("inner", ts, [&](auto record) {
+      received = record.ReadAll().result;
+      size = record.size;
+      return true;
+    }) == Error::kOk);
+    return true;
+  });
+
+  REQUIRE(err == Error::kOk);
+  REQUIRE(received == "inner-data");
+  REQUIRE(size == 10);
+}
+
+TEST_CASE("reduct::IBucket should call query callbacks inline", "[concurrency]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+
+  // empty records and records split between chunks
+  std::vector<std::string> written;
+  auto [batch_errors, batch_err] = bucket->WriteBatch("entry", [&](IBucket::Batch* batch) {
+    for (size_t i = 0; i < 50; ++i) {
+      written.emplace_back(i % 10 == 0 ? 0 : i * 10'000, static_cast<char>('a' + i % 26));
+      batch->AddRecord(ts + us(i), written.back());
+    }
+  });
+  REQUIRE(batch_err == Error::kOk);
+
+  for (bool head_only : {false, true}) {
+    std::vector<std::string> received;
+    const auto caller = std::this_thread::get_id();
+    auto err = bucket->Query("entry", std::nullopt, std::nullopt, {.head_only = head_only, .inline_callback = true},
+                             [&](auto record) {
+                               REQUIRE(std::this_thread::get_id() == caller);
+                               received.push_back(record.ReadAll().result);
+                               return true;
+                             });
+
+    REQUIRE(err == Error::kOk);
+    REQUIRE(received.size() == written.size());
+    if (!head_only) {
+      REQUIRE(received == written);
+    }
+  }
+
+  size_t count = 0;
+  auto err = bucket->Query("entry", std::nullopt, std::nullopt, {.inline_callback = true},
+                           [&count](auto) { return ++count < 5; });
+  REQUIRE(err == Error::kOk);
+  REQUIRE(count == 5);
+}
+
+TEST_CASE("reduct::IBucket query callbacks performance", "[concurrency][.benchmark]") {
+  constexpr size_t kRecords = 10'000;
+
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  auto [batch_errors, batch_err] = bucket->WriteBatch("entry", [&](IBucket::Batch* batch) {
+    for (size_t i = 0; i < kRecords; ++i) {
+      batch->AddRecord(ts + us(i), "small record");
+    }
+  });
+  REQUIRE(batch_err == Error::kOk);
+
+  for (bool head_only : {false, true}) {
+    for (bool inline_callback : {false, true}) {
+      BENCHMARK(fmt::format("{} {} records on {}", head_only ? "head" : "read", kRecords,
+                            inline_callback ? "receiving thread" : "executor")) {
+        size_t size = 0;
+        auto err = bucket->Query("entry", std::nullopt, std::nullopt,
+                                 {.head_only = head_only, .inline_callback = inline_callback}, [&size](auto record) {
+                                   size += record.ReadAll().result.size();
+                                   return true;
+                                 });
+        REQUIRE(err == Error::kOk);
+        return size;
+      };
+    }
+  }
+}
@@ -0,0 +1,248 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/coro.h"
+
+#include <catch2/catch.hpp>
+#include <fmt/core.h>
+
+#include <coroutine>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "reduct/executor.h"
+#include "stub_server.h"
+
+using reduct::Error;
+using reduct::IBucket;
+using reduct::IExecutor;
+using us = std::chrono::microseconds;
+
+namespace coro = reduct::coro;
+
+namespace {
+
+/**
+ * Minimal eager coroutine, the library doesn't provide a task type
+ */
+struct Task {
+  struct promise_type {
+    std::promise<void> done;
+
+    Task get_return_object() { return Task{done.get_future()}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() { done.set_value(); }
+    void unhandled_exception() { done.set_exception(std::current_exception()); }
+  };
+
+  std::future<void> finished;
+};
+
+Task WriteAndQuery(const IBucket& bucket, IBucket::Time ts, std::vector<std::string>* received, Error* error) {
+  for (int i = 0; i < 5; ++i) {
+    // a named variable, GCC 12 destroys a braced temporary in a co_await expression twice
+    IBucket::WriteOptions options{.timestamp = ts + us(i)};
+    *error = co_await coro::Write(bucket, "entry", std::move(options),
+                                  [i](auto rec) { rec->WriteAll(fmt::format("data-{}", i)); });
+    if (*error) {
+      co_return;
+    }
+  }
+
+  auto [batch_errors, batch_err] = co_await coro::WriteBatch(bucket, "entry", [ts](IBucket::Batch* batch) {
+    for (int i = 5; i < 10; ++i) {
+      batch->AddRecord(ts + us(i), fmt::format("data-{}", i));
+    }
+  });
+  if (batch_err) {
+    *error = batch_err;
+    co_return;
+  }
+
+  coro::QueryGenerator records(bucket, "entry", std::nullopt, std::nullopt, {});
+  while (auto record = co_await records.Next()) {
+    auto [data, err] = record->ReadAll();
+    received->push_back(data);
+  }
+  *error = records.error();
+}
+
+Task ReadAfterBreak(const IBucket& bucket, IBucket::Time ts, std::vector<std::string>* received, Error* error) {
+  {
+    coro::QueryGenerator records(bucket, "entry", std::nullopt, std::nullopt, {});
+    while (auto record = co_await records.Next()) {
+      received->push_back(record->ReadAll().result);
+      if (received->size() == 3) {
+        break;
+      }
+    }
+  }
+
+  *error = co_await coro::Read(bucket, "entry", ts + us(7), [received](auto record) {
+    received->push_back(record.ReadAll().result);
+    return true;
+  });
+}
+
+Task ReadInterleaved(const IBucket& bucket, IBucket::Time ts, std::vector<std::string>* received, Error* error) {
+  coro::QueryGenerator first(bucket, "entry", std::nullopt, std::nullopt, {});
+  coro::QueryGenerator second(bucket, "entry", std::nullopt, std::nullopt, {});
+  while (auto record = co_await first.Next()) {
+    received->push_back(record->ReadAll().result);
+
+    auto other = co_await second.Next();
+    received->push_back(other ? other->ReadAll().result : "");
+
+    *error = co_await coro::Read(bucket, "entry", ts + us(7), [received](auto record) {
+      received->push_back(record.ReadAll().result);
+      return true;
+    });
+    if (*error) {
+      co_return;
+    }
+  }
+
+  *error = first.error() ? first.error() : second.error();
+}
+
+Task FollowAndStop(const IBucket& bucket, IBucket::Time ts, std::vector<std::string>* received, Error* error) {
+  {
+    coro::QueryGenerator records(bucket, "entry", std::nullopt, std::nullopt,
+                                 {.continuous = true, .poll_interval = std::chrono::seconds(30)});
+    while (received->size() < 10) {
+      auto record = co_await records.Next();
+      if (!record) {
+        *error = records.error();
+        co_return;
+      }
+      received->push_back(record->ReadAll().result);
+    }
+
+    // the coroutine is resumed on an I/O thread and destroys the generator while the query waits for new records
+    *error = co_await coro::Read(bucket, "entry", ts + us(7), [received](auto record) {
+      received->push_back(record.ReadAll().result);
+      return true;
+    });
+  }
+}
+
+Task ReadBetweenRecords(const IBucket& bucket, IBucket::Time ts, std::vector<std::string>* received, Error* error) {
+  // only one record is buffered, the query waits for the consumer while it reads
+  coro::QueryGenerator records(bucket, "entry", std::nullopt, std::nullopt, {.max_buffer_size = 1});
+  while (auto record = co_await records.Next()) {
+    received->push_back(record->ReadAll().result);
+    *error = co_await coro::Read(bucket, "entry", ts + us(7), [received](auto record) {
+      received->push_back(record.ReadAll().result);
+      return true;
+    });
+    if (*error) {
+      co_return;
+    }
+  }
+
+  *error = records.error();
+}
+
+Task WriteAndDestroy(std::unique_ptr<IBucket> bucket, IBucket::Time ts, Error* error) {
+  IBucket::WriteOptions options{.timestamp = ts};
+  *error = co_await coro::Write(*bucket, "entry", std::move(options), [](auto rec) { rec->WriteAll("data"); });
+  // the coroutine runs on the I/O thread of the bucket, which doesn't count the write anymore
+  bucket.reset();
+}
+
+}  // namespace
+
+TEST_CASE("reduct::coro should write and query records", "[coro]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+
+  std::vector<std::string> received;
+  Error error;
+  auto task = WriteAndQuery(*bucket, ts, &received, &error);
+  REQUIRE(task.finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+  REQUIRE(error == Error::kOk);
+  REQUIRE(received.size() == 10);
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(received[i] == fmt::format("data-{}", i));
+  }
+
+  SECTION("stop query") {
+    received.clear();
+    auto read_task = ReadAfterBreak(*bucket, ts, &received, &error);
+    REQUIRE(read_task.finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+    REQUIRE(error == Error::kOk);
+    REQUIRE(received == std::vector<std::string>{"data-0", "data-1", "data-2", "data-7"});
+  }
+
+  SECTION("interleave generators and reads on one callback thread") {
+    auto single = IBucket::Build(server.url(), "test_bucket", {}, std::nullopt, IExecutor::Build(1));
+
+    received.clear();
+    auto read_task = ReadInterleaved(*single, ts, &received, &error);
+    REQUIRE(read_task.finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+    REQUIRE(error == Error::kOk);
+    REQUIRE(received.size() == 30);
+    for (int i = 0; i < 10; ++i) {
+      REQUIRE(received[i * 3] == fmt::format("data-{}", i));
+      REQUIRE(received[i * 3 + 1] == fmt::format("data-{}", i));
+      REQUIRE(received[i * 3 + 2] == "data-7");
+    }
+  }
+}
+
+TEST_CASE("reduct::coro should stop a continuous query when the generator is destroyed", "[coro]") {
+  StubServer server;
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {});
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(bucket->Write("entry", ts + us(i), [i](auto rec) { rec->WriteAll(fmt::format("data-{}", i)); }) ==
+            Error::kOk);
+  }
+
+  std::vector<std::string> received;
+  Error error;
+  auto task = FollowAndStop(*bucket, ts, &received, &error);
+  REQUIRE(task.finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  REQUIRE(error == Error::kOk);
+  REQUIRE(received.size() == 11);
+  REQUIRE(received.back() == "data-7");
+}
+
+TEST_CASE("reduct::coro should read while the generator waits for the consumer", "[coro]") {
+  StubServer server;
+  // the awaitables complete on the only I/O thread
+  auto bucket = IBucket::Build(server.url(), "test_bucket", {}, std::nullopt, nullptr, IExecutor::Build(1));
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(bucket->Write("entry", ts + us(i), [i](auto rec) { rec->WriteAll(fmt::format("data-{}", i)); }) ==
+            Error::kOk);
+  }
+
+  std::vector<std::string> received;
+  Error error;
+  auto task = ReadBetweenRecords(*bucket, ts, &received, &error);
+  REQUIRE(task.finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  REQUIRE(error == Error::kOk);
+  REQUIRE(received.size() == 20);
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(received[i * 2] == fmt::format("data-{}", i));
+    REQUIRE(received[i * 2 + 1] == "data-7");
+  }
+}
+
+TEST_CASE("reduct::coro should destroy the bucket after an operation", "[coro]") {
+  StubServer server;
+  const auto ts = IBucket::Time() + std::chrono::seconds(1);
+
+  Error error;
+  auto task = WriteAndDestroy(IBucket::Build(server.url(), "test_bucket", {}), ts, &error);
+  REQUIRE(task.finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  REQUIRE(error == Error::kOk);
+  REQUIRE(server.record_count("entry") == 1);
+}
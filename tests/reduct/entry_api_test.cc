@@ -134,6 +134,80 @@ TEST_CASE("reduct::IBucket should write a record in chunks", "[entry_api]") {
   REQUIRE(err == Error::kOk);
 }
 
+TEST_CASE("reduct::IBucket should write a record without copying", "[entry_api]") {
+  Fixture ctx;
+  auto [bucket, err] = ctx.client->CreateBucket(kBucketName);
+
+  REQUIRE(err == Error::kOk);
+  REQUIRE(bucket);
+
+  IBucket::Time ts = IBucket::Time::clock::now();
+  const auto blob = std::make_shared<const std::string>(10'000'000, 'x');
+
+  SECTION("shared blob") {
+    REQUIRE(bucket->Write("entry", ts, [blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  }
+
+  SECTION("view of blob") {
+    REQUIRE(bucket->Write("entry", ts, [&blob](auto rec) { rec->WriteAllView(*blob); }) == Error::kOk);
+  }
+
+  SECTION("view callback") {
+    REQUIRE(bucket->Write("entry", ts, [&blob](auto rec) {
+      rec->WriteView(blob->size(), [&](auto offset, auto size) {
+        // shorter chunks than requested
+        return std::pair{true, std::string_view(*blob).substr(offset, std::min<size_t>(size, 1000))};
+      });
+    }) == Error::kOk);
+  }
+
+  err = bucket->Read("entry", ts, [&blob](auto record) {
+    auto [data, read_err] = record.ReadAll();
+    REQUIRE(read_err == Error::kOk);
+    REQUIRE(data == *blob);
+
+    return true;
+  });
+
+  REQUIRE(err == Error::kOk);
+}
+
+TEST_CASE("reduct::IBucket should write compressed records", "[entry_api]") {
+  Fixture ctx;
+  auto [bucket, err] = ctx.client->CreateBucket(kBucketName);
+
+  REQUIRE(err == Error::kOk);
+  REQUIRE(bucket);
+
+  IBucket::Time ts = IBucket::Time() + s(1);
+  std::string blob;
+  for (int i = 0; i < 10'000; ++i) {
+    blob.append(fmt::format("value-{};", i % 100));
+  }
+
+  const IBucket::WriteOptions options{.timestamp = ts, .content_type = "text/plain",
+                                      .compression = reduct::Compression::kGzip};
+  REQUIRE(bucket->Write("entry", options, [&blob](auto rec) {
+    rec->WriteView(blob.size(), [&](auto offset, auto size) {
+      return std::pair{true, std::string_view(blob).substr(offset, std::min<size_t>(size, 1000))};
+    });
+  }) == Error::kOk);
+
+  REQUIRE(bucket->WriteBatch("entry", [&blob, ts](IBucket::Batch* batch) {
+    batch->AddRecord(ts + us(1), blob, reduct::Compression::kGzip, "text/plain");
+  }) == Error::kOk);
+
+  std::vector<std::string> received;
+  err = bucket->Query("entry", std::nullopt, std::nullopt, {}, [&received](auto record) {
+    REQUIRE(record.content_type == "text/plain");
+    received.push_back(record.ReadAll().result);
+    return true;
+  });
+
+  REQUIRE(err == Error::kOk);
+  REQUIRE(received == std::vector<std::string>{blob, blob});
+}
+
 TEST_CASE("reduct::IBucket should query records", "[entry_api][1_13]") {
   auto [head, content] = GENERATE(std::make_tuple(false, "some_data1some_data2some_data3"), std::make_tuple(true, ""));
   CAPTURE(head);
@@ -298,6 +372,101 @@ TEST_CASE("reduct::IBucket should query records (huge blobs)", "[entry_api]") {
   REQUIRE(received_data[1] == blob2);
 }
 
+TEST_CASE("reduct::IBucket should query records with limited buffer", "[entry_api]") {
+  Fixture ctx;
+  auto [bucket, _] = ctx.client->CreateBucket(kBucketName);
+  REQUIRE(bucket);
+
+  IBucket::Time ts{};
+  std::string blob(1'000'000, 'x');
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(bucket->Write("entry", ts + us(i), [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  }
+
+  auto stats = std::make_shared<IBucket::QueryStats>();
+  size_t received = 0;
+  auto err = bucket->Query("entry", ts, ts + us(5), {.max_buffer_size = 64'000, .stats = stats},
+                           [&received, &blob](auto record) {
+                             // a slow consumer, the transfer must wait for it
+                             std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                             auto [data, read_err] = record.ReadAll();
+                             REQUIRE(read_err == Error::kOk);
+                             REQUIRE(data == blob);
+                             received++;
+                             return true;
+                           });
+
+  REQUIRE(err == Error::kOk);
+  REQUIRE(received == 5);
+  REQUIRE(stats->blocked_us > 0);
+}
+
+TEST_CASE("reduct::IBucket should poll a continuous query adaptively", "[entry_api]") {
+  Fixture ctx;
+  auto [bucket, _] = ctx.client->CreateBucket(kBucketName);
+  REQUIRE(bucket);
+
+  IBucket::Time ts{};
+  REQUIRE(bucket->Write("entry", ts, [](auto rec) { rec->WriteAll("first"); }) == Error::kOk);
+
+  auto stats = std::make_shared<IBucket::QueryStats>();
+  std::vector<std::string> received;
+  auto future = bucket->QueryAsync(
+      "entry", ts, {},
+      {.continuous = true,
+       .poll_interval = std::chrono::milliseconds(100),
+       .min_poll_interval = std::chrono::milliseconds(1),
+       .stats = stats},
+      [&received](auto record) {
+        received.push_back(record.ReadAll().result);
+        return received.size() < 2;
+      });
+
+  // the query waits for the new record with growing intervals
+  while (stats->empty_polls < 5) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(bucket->Write("entry", ts + us(1), [](auto rec) { rec->WriteAll("second"); }) == Error::kOk);
+
+  REQUIRE(future.wait_for(s(5)) == std::future_status::ready);
+  REQUIRE(future.get() == Error::kOk);
+  REQUIRE(received == std::vector<std::string>{"first", "second"});
+  REQUIRE(stats->polls > stats->empty_polls);
+  REQUIRE(stats->poll_wait_us < 5 * 100'000);
+}
+
+TEST_CASE("reduct::IBucket should prefetch query pages", "[entry_api]") {
+  Fixture ctx;
+  auto [bucket, _] = ctx.client->CreateBucket(kBucketName);
+  REQUIRE(bucket);
+
+  // big records to get several pages
+  IBucket::Time ts{};
+  std::string blob(1'000'000, 'x');
+  for (int i = 0; i < 20; ++i) {
+    REQUIRE(bucket->Write("entry", ts + us(i), [&blob](auto rec) { rec->WriteAll(blob); }) == Error::kOk);
+  }
+
+  auto stats = std::make_shared<IBucket::QueryStats>();
+  size_t received = 0;
+  auto err = bucket->Query("entry", ts, ts + us(20), {.stats = stats, .prefetch_pages = 2},
+                           [&received, &blob](auto record) {
+                             REQUIRE(record.timestamp == IBucket::Time() + us(received));
+                             REQUIRE(record.ReadAll().result == blob);
+                             received++;
+                             return true;
+                           });
+
+  REQUIRE(err == Error::kOk);
+  REQUIRE(received == 20);
+  REQUIRE(stats->polls > 1);
+
+  received = 0;
+  err = bucket->Query("entry", ts, ts + us(20), {.prefetch_pages = 2}, [&received](auto) { return ++received < 3; });
+  REQUIRE(err == Error::kOk);
+  REQUIRE(received == 3);
+}
+
 TEST_CASE("reduct::IBucket should query multiple entries", "[entry_api][1_18]") {
   Fixture ctx;
   auto [bucket, _] = ctx.client->CreateBucket(kBucketName);
@@ -321,10 +490,94 @@ TEST_CASE("reduct::IBucket should query multiple entries", "[entry_api][1_18]")
   REQUIRE(received == std::map<std::string, std::string>{{"entry-a", "aaa"}, {"entry-b", "bbb"}});
 }
 
+TEST_CASE("reduct::IBucket should query multiple entries in parallel", "[entry_api][1_18]") {
+  Fixture ctx;
+  auto [bucket, _] = ctx.client->CreateBucket(kBucketName);
+  REQUIRE(bucket);
+
+  IBucket::Time ts{};
+  const std::vector<std::string> entries = {"entry-a", "entry-b", "entry-c"};
+  for (int i = 0; i < 30; ++i) {
+    REQUIRE(bucket->Write(entries[i % 3], ts + us(i), [i](auto rec) { rec->WriteAll(std::to_string(i)); }) ==
+            Error::kOk);
+  }
+
+  SECTION("ordered") {
+    std::vector<std::string> received;
+    auto err = bucket->Query(entries, ts, ts + us(30), {.max_parallel = 2}, [&received](auto record) {
+      REQUIRE(record.timestamp == IBucket::Time() + us(received.size()));
+      REQUIRE(record.last == (received.size() == 29));
+      received.push_back(record.ReadAll().result);
+      return true;
+    });
+
+    REQUIRE(err == Error::kOk);
+    REQUIRE(received.size() == 30);
+    REQUIRE(received[10] == "10");
+  }
+
+  SECTION("unordered") {
+    std::set<std::string> received;
+    size_t last_count = 0;
+    auto err = bucket->Query(entries, ts, ts + us(30), {.max_parallel = 2, .ordered_merge = false},
+                             [&received, &last_count](auto record) {
+                               received.insert(record.ReadAll().result);
+                               last_count += record.last ? 1 : 0;
+                               REQUIRE((!record.last || received.size() == 30));
+                               return true;
+                             });
+
+    REQUIRE(err == Error::kOk);
+    REQUIRE(received.size() == 30);
+    REQUIRE(last_count == 1);
+  }
+
+  SECTION("stopped") {
+    size_t count = 0;
+    auto err = bucket->Query(entries, ts, ts + us(30), {.max_parallel = 3}, [&count](auto) { return ++count < 5; });
+
+    REQUIRE(err == Error::kOk);
+    REQUIRE(count == 5);
+  }
+}
+
+TEST_CASE("reduct::IBucket should query time slices of an entry in parallel", "[entry_api][1_18]") {
+  Fixture ctx;
+  auto [bucket, _] = ctx.client->CreateBucket(kBucketName);
+  REQUIRE(bucket);
+
+  IBucket::Time ts = IBucket::Time() + s(1);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(bucket->Write("entry", ts + us(i * 7), [i](auto rec) { rec->WriteAll(std::to_string(i)); }) ==
+            Error::kOk);
+  }
+
+  for (auto [start, stop] : {std::pair<std::optional<IBucket::Time>, std::optional<IBucket::Time>>{ts, ts + us(700)},
+                             {std::nullopt, std::nullopt}}) {
+    std::vector<std::string> received;
+    auto err = bucket->Query("entry", start, stop, {.max_parallel = 4}, [&received](auto record) {
+      REQUIRE(record.timestamp == IBucket::Time() + s(1) + us(received.size() * 7));
+      received.push_back(record.ReadAll().result);
+      return true;
+    });
+
+    REQUIRE(err == Error::kOk);
+    REQUIRE(received.size() == 100);
+    REQUIRE(received.back() == "99");
+  }
+
+  std::set<std::string> unordered;
+  auto err = bucket->Query("entry", {}, {}, {.max_parallel = 4, .ordered_merge = false}, [&unordered](auto record) {
+    unordered.insert(record.ReadAll().result);
+    return true;
+  });
+  REQUIRE(err == Error::kOk);
+  REQUIRE(unordered.size() == 100);
+}
+
 TEST_CASE("reduct::internal::ParseAndBuildBatchedRecordsV2 should handle empty batch", "[entry_api][1_18]") {
   // Test the parsing function directly with empty entries header
-  std::deque<std::optional<std::string>> data;
-  std::mutex mutex;
+  reduct::internal::ChunkQueue data;
 
   // Simulate empty batch response with empty entries header
   reduct::internal::IHttpClient::Headers headers;
@@ -332,7 +585,7 @@ TEST_CASE("reduct::internal::ParseAndBuildBatchedRecordsV2 should handle empty b
   headers["x-reduct-start-ts"] = "0";
   headers["x-reduct-last"] = "true";
 
-  auto records = reduct::internal::ParseAndBuildBatchedRecordsV2(&data, &mutex, false, std::move(headers));
+  auto records = reduct::internal::ParseAndBuildBatchedRecordsV2(&data, false, std::move(headers));
 
   REQUIRE(records.empty());  // Should return empty records, not crash
 }
@@ -0,0 +1,268 @@
+// Copyright 2026 ReductSoftware UG
+
+#include "reduct/executor.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
+
+using reduct::Error;
+using reduct::IExecutor;
+using reduct::RunParallel;
+using reduct::TaskGroup;
+
+TEST_CASE("reduct::IExecutor should run submitted tasks", "[executor]") {
+  auto executor = IExecutor::Build(4);
+  REQUIRE(executor->ThreadCount() == 4);
+
+  std::atomic<int> counter = 0;
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 100; ++i) {
+    IExecutor::Task task([&counter] { counter++; });
+    futures.push_back(task.get_future());
+    executor->Submit(std::move(task));
+  }
+
+  for (auto& future : futures) {
+    future.wait();
+  }
+
+  REQUIRE(counter == 100);
+}
+
+TEST_CASE("reduct::IExecutor should run tasks in parallel", "[executor]") {
+  auto executor = IExecutor::Build(2);
+
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> running = 0;
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 2; ++i) {
+    IExecutor::Task task([&] {
+      running++;
+      // wait until both tasks are running, it blocks forever with one thread
+      while (running < 2) {
+        std::this_thread::yield();
+      }
+      std::lock_guard lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+    futures.push_back(task.get_future());
+    executor->Submit(std::move(task));
+  }
+
+  for (auto& future : futures) {
+    REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  }
+  REQUIRE(threads.size() == 2);
+}
+
+TEST_CASE("reduct::IExecutor should create at least one thread", "[executor]") {
+  auto executor = IExecutor::Build(0);
+  REQUIRE(executor->ThreadCount() == 1);
+
+  IExecutor::Task task([] {});
+  auto future = task.get_future();
+  executor->Submit(std::move(task));
+  REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+}
+
+TEST_CASE("reduct::IExecutor should know its worker threads", "[executor]") {
+  auto executor = IExecutor::Build(1);
+  auto other = IExecutor::Build(1);
+  REQUIRE_FALSE(executor->InWorkerThread());
+
+  bool in_worker = false;
+  bool in_other = true;
+  IExecutor::Task task([&] {
+    in_worker = executor->InWorkerThread();
+    in_other = other->InWorkerThread();
+  });
+  auto future = task.get_future();
+  executor->Submit(std::move(task));
+  future.wait();
+
+  REQUIRE(in_worker);
+  REQUIRE_FALSE(in_other);
+}
+
+TEST_CASE("reduct::IExecutor should finish pending tasks when destroyed", "[executor]") {
+  std::atomic<int> counter = 0;
+  {
+    auto executor = IExecutor::Build(1);
+    for (int i = 0; i < 10; ++i) {
+      executor->Submit(IExecutor::Task([&counter] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        counter++;
+      }));
+    }
+  }
+
+  REQUIRE(counter == 10);
+}
+
+TEST_CASE("reduct::IExecutor should be destroyed by its task", "[executor]") {
+  auto executor = IExecutor::Build(2);
+  std::promise<void> destroyed;
+  std::atomic<int> counter = 0;
+  for (int i = 0; i < 10; ++i) {
+    executor->Submit(IExecutor::Task([&counter] { counter++; }));
+  }
+  executor->Submit(IExecutor::Task([&executor, &destroyed] {
+    executor.reset();
+    destroyed.set_value();
+  }));
+
+  REQUIRE(destroyed.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  REQUIRE(executor == nullptr);
+  REQUIRE(counter == 10);
+}
+
+TEST_CASE("reduct::TaskGroup should wait only for started tasks", "[executor]") {
+  auto executor = IExecutor::Build(1);
+  std::atomic<int> counter = 0;
+
+  SECTION("started") {
+    TaskGroup tasks(executor.get());
+    std::promise<void> started;
+    tasks.Submit([&] {
+      started.set_value();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      counter++;
+    });
+
+    started.get_future().wait();
+    tasks.Wait();
+    REQUIRE(counter == 1);
+  }
+
+  SECTION("not started on a busy executor") {
+    std::promise<void> release;
+    executor->Submit(IExecutor::Task([future = release.get_future().share()] { future.wait(); }));
+
+    {
+      TaskGroup tasks(executor.get());
+      tasks.Submit([&counter] { counter++; });
+    }
+
+    release.set_value();
+    IExecutor::Task last([] {});
+    auto done = last.get_future();
+    executor->Submit(std::move(last));
+    done.wait();
+    REQUIRE(counter == 0);
+  }
+}
+
+TEST_CASE("reduct::RunParallel should run tasks in parallel", "[executor]") {
+  auto executor = IExecutor::Build(4);
+  std::mutex mutex;
+  std::set<size_t> done;
+  auto task = [&](size_t idx, std::stop_token) {
+    std::lock_guard lock(mutex);
+    done.insert(idx);
+    return Error::kOk;
+  };
+
+  SECTION("on the executor") { REQUIRE(RunParallel(10, 4, executor.get(), task) == Error::kOk); }
+
+  SECTION("without executor") { REQUIRE(RunParallel(10, 4, nullptr, task) == Error::kOk); }
+
+  SECTION("on the only thread of the executor") {
+    auto single = IExecutor::Build(1);
+    IExecutor::Task run([&] { REQUIRE(RunParallel(10, 4, single.get(), task) == Error::kOk); });
+    auto future = run.get_future();
+    single->Submit(std::move(run));
+    REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  }
+
+  REQUIRE(done.size() == 10);
+}
+
+TEST_CASE("reduct::RunParallel should stop the tasks after an error", "[executor]") {
+  auto executor = IExecutor::Build(2);
+  std::atomic<int> started = 0;
+  std::atomic<bool> stopped = false;
+
+  auto err = RunParallel(10, 2, executor.get(), [&](size_t idx, std::stop_token stop_token) {
+    started++;
+    if (idx == 0) {
+      // waits for the failure of the other task
+      while (!stop_token.stop_requested()) {
+        std::this_thread::yield();
+      }
+      stopped = true;
+      return Error::kOk;
+    }
+    return Error{.code = 500, .message = "failed"};
+  });
+
+  REQUIRE(err == Error{.code = 500, .message = "failed"});
+  REQUIRE(stopped);
+  REQUIRE(started == 2);
+}
+
+TEST_CASE("reduct::IExecutor latency", "[executor][.benchmark]") {
+  // the model used before the executor: a worker per bucket polling a queue with sleeps
+  struct PollingWorker {
+    PollingWorker() {
+      worker = std::thread([this] {
+        while (!stop) {
+          std::optional<IExecutor::Task> task;
+          {
+            std::lock_guard lock(mutex);
+            if (!tasks.empty()) {
+              task = std::move(tasks.front());
+              tasks.pop_front();
+            }
+          }
+
+          if (task) {
+            (*task)();
+          } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+          }
+        }
+      });
+    }
+
+    ~PollingWorker() {
+      stop = true;
+      worker.join();
+    }
+
+    void Submit(IExecutor::Task task) {
+      std::lock_guard lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+
+    std::thread worker;
+    std::deque<IExecutor::Task> tasks;
+    std::mutex mutex;
+    std::atomic<bool> stop = false;
+  };
+
+  PollingWorker polling_worker;
+  auto executor = IExecutor::Build(1);
+
+  BENCHMARK("polling worker") {
+    IExecutor::Task task([] {});
+    auto future = task.get_future();
+    polling_worker.Submit(std::move(task));
+    future.wait();
+  };
+
+  BENCHMARK("executor") {
+    IExecutor::Task task([] {});
+    auto future = task.get_future();
+    executor->Submit(std::move(task));
+    future.wait();
+  };
+}
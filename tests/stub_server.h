@@ -0,0 +1,199 @@
+// Copyright 2026 ReductSoftware UG
+
+#ifndef REDUCT_CPP_STUB_SERVER_H
+#define REDUCT_CPP_STUB_SERVER_H
+
+#include <fmt/core.h>
+#include <httplib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+/**
+ * Local stand-in of the ReductStore HTTP API for tests which don't need a real server.
+ *
+ * It keeps records of all buckets in memory and supports the batch protocol v1: writing and reading single records,
+ * writing batches, renaming a bucket and queries which return all records in one batch. A continuous query
+ * gets no new records after that.
+ */
+class StubServer {
+ public:
+  StubServer() {
+    server_.Post(R"(/api/v1/b/([^/]+)/([^/]+))", [this](const httplib::Request& req, httplib::Response& res) {
+      std::lock_guard lock(mutex_);
+      entries_[req.matches[2]][std::stoull(req.get_param_value("ts"))] = req.body;
+    });
+
+    server_.Get(R"(/api/v1/b/([^/]+)/([^/]+))", [this](const httplib::Request& req, httplib::Response& res) {
+      std::lock_guard lock(mutex_);
+      auto& records = entries_[req.matches[2]];
+      auto record = records.find(std::stoull(req.get_param_value("ts")));
+      if (record == records.end()) {
+        res.status = 404;
+        return;
+      }
+
+      res.set_header("x-reduct-time", std::to_string(record->first));
+      if (!chunked_records_) {
+        res.set_content(record->second, "text/plain");
+        return;
+      }
+
+      // no content length, the data is sent in two chunks
+      res.set_chunked_content_provider("text/plain", [data = record->second](size_t, httplib::DataSink& sink) {
+        const auto half = data.size() / 2;
+        sink.write(data.data(), half);
+        sink.write(data.data() + half, data.size() - half);
+        sink.done();
+        return true;
+      });
+    });
+
+    server_.Post(R"(/api/v1/b/([^/]+)/([^/]+)/batch)", [this](const httplib::Request& req, httplib::Response& res) {
+      // the client sends the body in the order of timestamps
+      std::map<uint64_t, size_t> sizes;
+      for (const auto& [key, value] : req.headers) {
+        if (key.starts_with("x-reduct-time-")) {
+          sizes[std::stoull(key.substr(14))] = std::stoull(value.substr(0, value.find(',')));
+        }
+      }
+
+      std::lock_guard lock(mutex_);
+      if (batch_count_++ >= max_batches_) {
+        res.status = 503;
+        return;
+      }
+
+      size_t offset = 0;
+      for (auto [ts, size] : sizes) {
+        entries_[req.matches[2]][ts] = req.body.substr(offset, size);
+        offset += size;
+      }
+    });
+
+    server_.Post(R"(/api/v1/b/([^/]+)/([^/]+)/q)", [this](const httplib::Request& req, httplib::Response& res) {
+      std::lock_guard lock(mutex_);
+      const auto id = ++query_count_;
+      queries_[id] = entries_[req.matches[2]];
+      if (req.body.find(R"("continuous":true)") != std::string::npos) {
+        continuous_queries_.insert(id);
+      }
+      res.set_content(fmt::format(R"({{"id": {}}})", id), "application/json");
+    });
+
+    server_.Get(R"(/api/v1/b/([^/]+)/([^/]+)/batch)", [this](const httplib::Request& req, httplib::Response& res) {
+      std::lock_guard lock(mutex_);
+      auto query = queries_.find(std::stoull(req.get_param_value("q")));
+      if (query == queries_.end() || query->second.empty()) {
+        res.status = 204;
+        return;
+      }
+
+      std::string body;
+      for (const auto& [ts, data] : query->second) {
+        res.set_header(fmt::format("x-reduct-time-{}", ts), fmt::format("{},text/plain", data.size()));
+        body.append(data);
+      }
+      if (!continuous_queries_.contains(query->first)) {
+        res.set_header("x-reduct-last", "true");
+      }
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+      // httplib doesn't compress binary content, so the body is compressed here
+      if (req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos) {
+        std::string compressed;
+        httplib::detail::gzip_compressor().compress(body.data(), body.size(), true, [&](const char* data, size_t size) {
+          compressed.append(data, size);
+          return true;
+        });
+        body = std::move(compressed);
+        res.set_header("Content-Encoding", "gzip");
+        compressed_responses_++;
+      }
+#endif
+      res.set_content(body, "application/octet-stream");
+      queries_.erase(query);
+    });
+
+    // bucket names are ignored, so renaming is a no-op
+    server_.Put(R"(/api/v1/b/([^/]+)/rename)", [](const httplib::Request& req, httplib::Response& res) {});
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+    // httplib decodes gzip request bodies, the server advertises it to the client (RFC 7694)
+    server_.set_post_routing_handler([this](const httplib::Request& req, httplib::Response& res) {
+      res.set_header("Accept-Encoding", "gzip");
+      if (req.get_header_value("Content-Encoding") == "gzip") {
+        compressed_requests_++;
+      }
+    });
+#endif
+
+    port_ = server_.bind_to_any_port("127.0.0.1");
+    thread_ = std::thread([this] { server_.listen_after_bind(); });
+    server_.wait_until_ready();
+  }
+
+  ~StubServer() {
+    server_.stop();
+    thread_.join();
+  }
+
+  StubServer(const StubServer&) = delete;
+  StubServer& operator=(const StubServer&) = delete;
+
+  [[nodiscard]] std::string url() const { return fmt::format("http://127.0.0.1:{}", port_); }
+
+  /**
+   * Number of records stored in an entry
+   */
+  [[nodiscard]] size_t record_count(const std::string& entry) {
+    std::lock_guard lock(mutex_);
+    return entries_[entry].size();
+  }
+
+  /**
+   * Number of requests with a gzip compressed body
+   */
+  [[nodiscard]] size_t compressed_requests() const { return compressed_requests_; }
+
+  /**
+   * Number of responses with a gzip compressed body
+   */
+  [[nodiscard]] size_t compressed_responses() const { return compressed_responses_; }
+
+  /**
+   * Send single records with chunked transfer encoding, without the content length
+   */
+  void chunked_records(bool chunked) { chunked_records_ = chunked; }
+
+  /**
+   * Reject the batches written after the given number of batches with 503
+   */
+  void fail_batches_after(size_t count) {
+    std::lock_guard lock(mutex_);
+    max_batches_ = count;
+  }
+
+ private:
+  httplib::Server server_;
+  std::thread thread_;
+  int port_;
+
+  std::mutex mutex_;
+  std::map<std::string, std::map<uint64_t, std::string>> entries_;
+  std::map<uint64_t, std::map<uint64_t, std::string>> queries_;
+  std::set<uint64_t> continuous_queries_;
+  uint64_t query_count_ = 0;
+  size_t batch_count_ = 0;
+  size_t max_batches_ = std::numeric_limits<size_t>::max();
+  std::atomic<size_t> compressed_requests_ = 0;
+  std::atomic<size_t> compressed_responses_ = 0;
+  std::atomic<bool> chunked_records_ = false;
+};
+
+#endif  // REDUCT_CPP_STUB_SERVER_H